@@ -9,6 +9,10 @@ DEFINES += APP_VERSION=\\\"$$VERSION\\\"
 
 QT       += core gui
 QT       += dbus
+QT       += concurrent
+
+# the PNG writer deflates with zlib directly
+LIBS     += -lz
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -42,6 +46,8 @@ SOURCES += src/main.cpp\
     src/infowindow.cpp \
     src/config/configwindow.cpp \
     src/capture/screenshot.cpp \
+    src/capture/tiledimage.cpp \
+    src/capture/renderstatistics.cpp \
     src/capture/widget/capturewidget.cpp \
     src/capture/capturemodification.cpp \
     src/capture/widget/colorpicker.cpp \
@@ -72,25 +78,40 @@ SOURCES += src/main.cpp\
     src/capture/tools/toolfactory.cpp \
     src/utils/filenamehandler.cpp \
     src/utils/screengrabber.cpp \
+    src/utils/pngwriter.cpp \
+    src/utils/qoiwriter.cpp \
+    src/utils/imageencoder.cpp \
+    src/utils/pngoptimizer.cpp \
+    src/utils/sealedimage.cpp \
+    src/utils/filenameindex.cpp \
+    src/utils/filenamepattern.cpp \
     src/utils/confighandler.cpp \
     src/utils/systemnotification.cpp \
     src/cli/commandlineparser.cpp \
     src/cli/commandoption.cpp \
     src/cli/commandargument.cpp \
     src/capture/workers/screenshotsaver.cpp \
+    src/capture/workers/burstcapture.cpp \
+    src/capture/workers/tilearchive.cpp \
+    src/capture/workers/savetask.cpp \
+    src/capture/workers/optimizetask.cpp \
+    src/capture/workers/archivetask.cpp \
     src/capture/workers/imgur/imguruploader.cpp \
     src/capture/workers/graphicalscreenshotsaver.cpp \
     src/capture/workers/imgur/loadspinner.cpp \
     src/capture/workers/imgur/imagelabel.cpp \
     src/capture/workers/imgur/notificationwidget.cpp \
     src/core/resourceexporter.cpp \
-    src/capture/widget/notifierbox.cpp
+    src/capture/widget/notifierbox.cpp \
+    src/capture/widget/repaintscheduler.cpp
 
 HEADERS  += \
     src/capture/widget/buttonhandler.h \
     src/infowindow.h \
     src/config/configwindow.h \
     src/capture/screenshot.h \
+    src/capture/tiledimage.h \
+    src/capture/renderstatistics.h \
     src/capture/widget/capturewidget.h \
     src/capture/capturemodification.h \
     src/capture/widget/colorpicker.h \
@@ -103,6 +124,13 @@ HEADERS  += \
     src/utils/filenamehandler.h \
     src/config/strftimechooserwidget.h \
     src/utils/screengrabber.h \
+    src/utils/pngwriter.h \
+    src/utils/qoiwriter.h \
+    src/utils/imageencoder.h \
+    src/utils/pngoptimizer.h \
+    src/utils/sealedimage.h \
+    src/utils/filenameindex.h \
+    src/utils/filenamepattern.h \
     src/capture/tools/capturetool.h \
     src/capture/widget/capturebutton.h \
     src/capture/tools/penciltool.h \
@@ -127,17 +155,31 @@ HEADERS  += \
     src/cli/commandoption.h \
     src/cli/commandargument.h \
     src/capture/workers/screenshotsaver.h \
+    src/capture/workers/burstcapture.h \
+    src/capture/workers/tilearchive.h \
+    src/capture/workers/savetask.h \
+    src/capture/workers/optimizetask.h \
+    src/capture/workers/archivetask.h \
     src/capture/workers/imgur/imguruploader.h \
     src/capture/workers/graphicalscreenshotsaver.h \
     src/capture/workers/imgur/loadspinner.h \
     src/capture/workers/imgur/imagelabel.h \
     src/capture/workers/imgur/notificationwidget.h \
     src/core/resourceexporter.h \
-    src/capture/widget/notifierbox.h
+    src/capture/widget/notifierbox.h \
+    src/capture/widget/repaintscheduler.h
 
 RESOURCES += \
     graphics.qrc
 
+# fast screen grabs with the MIT-SHM extension of X11
+packagesExist(xcb xcb-shm) {
+    PKGCONFIG += xcb xcb-shm
+    DEFINES += USE_XCB_SHM
+    SOURCES += src/utils/xshmgrabber.cpp
+    HEADERS += src/utils/xshmgrabber.h
+}
+
 # installs
 unix: {
     packaging {
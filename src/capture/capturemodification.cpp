@@ -20,22 +20,61 @@
 #include "src/capture/tools/toolfactory.h"
 #include "src/capture/tools/capturetool.h"
 #include <QColor>
+#include <QLineF>
+#include <qmath.h>
+
+namespace {
+
+// points of a path closer than this distance (manhattan length) to the
+// previous one are discarded
+const int MIN_POINT_DISTANCE = 2;
+// the last point of a path is replaced by the new one when it, and every
+// point it replaced before, deviates less than this distance from the
+// segment which joins the previous point and the new one
+const qreal ALIGNMENT_TOLERANCE = 0.75;
+// replaced points checked at most for a segment, the next point starts a
+// new segment when there are more
+const int MAX_DROPPED_POINTS = 64;
+
+// distanceToSegment is the distance to the nearest end when the point is
+// beyond them, else the area of the parallelogram of the segment and the
+// point, the cross product, divided by the length of the segment
+qreal distanceToSegment(const QPointF &p, const QLineF &segment) {
+    QPointF d = segment.p2() - segment.p1();
+    QPointF v = p - segment.p1();
+    qreal lengthSquared = QPointF::dotProduct(d, d);
+    qreal projection = QPointF::dotProduct(v, d);
+    if (lengthSquared == 0 || projection <= 0) {
+        return QLineF(p, segment.p1()).length();
+    } else if (projection >= lengthSquared) {
+        return QLineF(p, segment.p2()).length();
+    }
+    return qAbs(d.x() * v.y() - d.y() * v.x()) / qSqrt(lengthSquared);
+}
+
+} // unnamed namespace
 
 // CaptureModification is a single modification in the screenshot drawn
-// by the user.
+// by the user. It is a value type, the tool used to render it is shared by
+// all the modifications of the same type.
+
+CaptureModification::CaptureModification() :
+    m_type(CaptureButton::TYPE_PENCIL),
+    m_thickness(0)
+{
+    m_tool = ToolFactory::sharedTool(m_type);
+}
 
 CaptureModification::CaptureModification(
         const CaptureButton::ButtonType t,
         const QPoint &p,
         const QColor &c,
-        const int thickness,
-        QObject *parent) :
-    QObject(parent),
+        const int thickness) :
     m_color(c),
     m_type(t),
     m_thickness(thickness)
 {
-    m_tool = ToolFactory().CreateTool(t, this);
+    m_tool = ToolFactory::sharedTool(t);
     m_coords.append(p);
     if (m_tool->isSelectable()) {
         m_coords.append(p);
@@ -50,11 +89,11 @@ QColor CaptureModification::color() const {
     return m_color;
 }
 
-QVector<QPoint> CaptureModification::points() const {
+const QVector<QPoint> &CaptureModification::points() const {
     return m_coords;
 }
 
-CaptureTool* CaptureModification::tool() const{
+const CaptureTool* CaptureModification::tool() const{
     return m_tool;
 }
 
@@ -62,11 +101,50 @@ int CaptureModification::thickness() const {
     return m_thickness;
 }
 
-// addPoint adds a point to the vector of points
+// boundingRect returns the area of the screenshot which can be affected
+// when the modification is painted
+QRect CaptureModification::boundingRect() const {
+    return m_tool->boundingRect(m_coords, m_thickness);
+}
+
+// addPoint adds a point to the vector of points. The paths are simplified
+// as the points arrive so their size doesn't depend on the mouse rate, every
+// point added stays within ALIGNMENT_TOLERANCE of the simplified path, or
+// within 1px of one of its points when it's closer than MIN_POINT_DISTANCE
+// to the last one.
 void CaptureModification::addPoint(const QPoint p) {
     if (m_tool->toolType() == CaptureTool::TYPE_LINE_DRAWER) {
         m_coords[1] = p;
-    } else {
-        m_coords.append(p);
+    } else if ((p - m_coords.last()).manhattanLength() >= MIN_POINT_DISTANCE) {
+        if (canReplaceLast(p)) {
+            m_droppedPoints.append(m_coords.last());
+            m_coords.last() = p;
+        } else {
+            m_droppedPoints.clear();
+            m_coords.append(p);
+        }
+    } else if (m_droppedPoints.size() < MAX_DROPPED_POINTS) {
+        // it's checked if the last point is replaced
+        m_droppedPoints.append(p);
+    }
+}
+
+// canReplaceLast checks if the last point of the path and the points it
+// replaced are close to the segment from the previous point of the path to
+// the new one, so the error of the simplification doesn't accumulate
+bool CaptureModification::canReplaceLast(const QPoint &p) const {
+    int size = m_coords.size();
+    if (size < 2 || m_droppedPoints.size() >= MAX_DROPPED_POINTS) {
+        return false;
+    }
+    QLineF segment(m_coords.at(size - 2), p);
+    if (distanceToSegment(m_coords.last(), segment) > ALIGNMENT_TOLERANCE) {
+        return false;
+    }
+    for (const QPoint &dropped: m_droppedPoints) {
+        if (distanceToSegment(dropped, segment) > ALIGNMENT_TOLERANCE) {
+            return false;
+        }
     }
+    return true;
 }
@@ -19,27 +19,27 @@
 #define CAPTURECHANGE_H
 
 #include "src/capture/widget/capturebutton.h"
-#include <QObject>
+#include <QColor>
 #include <QVector>
+#include <QPoint>
 
 class CaptureButton;
-class QPoint;
+class CaptureTool;
 
-class CaptureModification : public QObject {
-    Q_OBJECT
+class CaptureModification {
 public:
-    CaptureModification(QObject *parent = nullptr) = delete;
+    CaptureModification();
     CaptureModification(
             const CaptureButton::ButtonType,
             const QPoint &initialPoint,
             const QColor &color,
-            const int thickness,
-            QObject *parent = nullptr
+            const int thickness
             );
     QColor color() const;
-    QVector<QPoint> points() const;
-    CaptureTool* tool() const;
+    const QVector<QPoint> &points() const;
+    const CaptureTool* tool() const;
     int thickness() const;
+    QRect boundingRect() const;
     CaptureButton::ButtonType buttonType() const;
     void addPoint(const QPoint);
 
@@ -47,9 +47,15 @@ protected:
     QColor m_color;
     CaptureButton::ButtonType m_type;
     QVector<QPoint> m_coords;
-    CaptureTool *m_tool;
+    const CaptureTool *m_tool;
     int m_thickness;
+    // points replaced by the last one of the path
+    QVector<QPoint> m_droppedPoints;
+
+    bool canReplaceLast(const QPoint &p) const;
 
 };
 
+Q_DECLARE_TYPEINFO(CaptureModification, Q_MOVABLE_TYPE);
+
 #endif // CAPTURECHANGE_H
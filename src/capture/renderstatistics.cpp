@@ -0,0 +1,164 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "renderstatistics.h"
+#include "src/utils/confighandler.h"
+#include <QStandardPaths>
+#include <QDateTime>
+#include <QTextStream>
+#include <QFile>
+#include <QDir>
+
+// RenderStatistics measures the cost of the capture rendering: paint time
+// and pixels of each frame, latency from the input to the paint and the
+// time spent by Screenshot and the tools. It is shown in the capture and
+// saved when it is closed.
+
+namespace {
+
+const char *ENV_VARIABLE = "FLAMESHOT_RENDER_STATISTICS";
+const char *SUMMARY_FILENAME = "render-statistics.log";
+
+QString milliseconds(const qint64 nanoseconds) {
+    return QString::number(nanoseconds / 1000000.0, 'f', 2);
+}
+
+} // unnamed namespace
+
+RenderStatistics::Counter::Counter() : count(0), total(0), max(0), last(0) {
+}
+
+void RenderStatistics::Counter::add(const qint64 value) {
+    ++count;
+    total += value;
+    max = qMax(max, value);
+    last = value;
+}
+
+// text returns the last, average and max times in milliseconds
+QString RenderStatistics::Counter::text() const {
+    qint64 average = count > 0 ? total / count : 0;
+    return QStringLiteral("%1 ms (avg %2, max %3)")
+            .arg(milliseconds(last), milliseconds(average), milliseconds(max));
+}
+
+RenderStatistics::RenderStatistics() : m_grabTime(0), m_firstFrameLatency(0) {
+    m_sessionTimer.start();
+}
+
+// isEnabled returns true if the statistics are enabled in the config or with
+// the FLAMESHOT_RENDER_STATISTICS environment variable
+bool RenderStatistics::isEnabled() {
+    return qEnvironmentVariableIsSet(ENV_VARIABLE)
+            || ConfigHandler().renderStatisticsValue();
+}
+
+// inputReceived starts the latency timer if all the previous input
+// events were painted
+void RenderStatistics::inputReceived() {
+    if (!m_inputTimer.isValid()) {
+        m_inputTimer.start();
+    }
+}
+
+void RenderStatistics::addFrame(const qint64 paintTime, const qint64 pixels) {
+    m_paintTime.add(paintTime);
+    m_pixels.add(pixels);
+    if (m_inputTimer.isValid()) {
+        m_latency.add(m_inputTimer.nsecsElapsed());
+        m_inputTimer.invalidate();
+    }
+}
+
+// addFrameInterval adds the time between two frames rendered back to back,
+// the intervals after an idle period are not passed so the frame rate
+// measures the rendering and not the input
+void RenderStatistics::addFrameInterval(const qint64 interval) {
+    m_frameInterval.add(interval);
+}
+
+void RenderStatistics::addTemporalPaint(const qint64 time) {
+    m_temporalPaint.add(time);
+}
+
+void RenderStatistics::addModificationPaint(const qint64 time) {
+    m_modificationPaint.add(time);
+}
+
+void RenderStatistics::addToolCost(const QString &toolName, const qint64 time) {
+    m_toolCosts[toolName].add(time);
+}
+
+// setCaptureLatency sets the time spent grabbing the screens and the time
+// from the capture request to its first frame
+void RenderStatistics::setCaptureLatency(const qint64 grabTime,
+                                         const qint64 firstFrame)
+{
+    m_grabTime = grabTime;
+    m_firstFrameLatency = firstFrame;
+}
+
+QStringList RenderStatistics::hudLines() const {
+    QStringList lines;
+    lines << QStringLiteral("grab: %1 ms, first frame: %2 ms")
+             .arg(milliseconds(m_grabTime), milliseconds(m_firstFrameLatency))
+          << QStringLiteral("paint: %1").arg(m_paintTime.text())
+          << QStringLiteral("cadence: %1 fps, interval %2")
+             .arg(m_frameInterval.total > 0 ?
+                      m_frameInterval.count * 1000000000.0
+                      / m_frameInterval.total : 0, 0, 'f', 1)
+             .arg(m_frameInterval.text())
+          << QStringLiteral("pixels: %1").arg(m_pixels.last)
+          << QStringLiteral("latency: %1").arg(m_latency.text())
+          << QStringLiteral("temporal: %1").arg(m_temporalPaint.text())
+          << QStringLiteral("commit: %1").arg(m_modificationPaint.text());
+    for (auto it = m_toolCosts.constBegin(); it != m_toolCosts.constEnd(); ++it) {
+        lines << QStringLiteral("%1: %2").arg(it.key(), it.value().text());
+    }
+    return lines;
+}
+
+QString RenderStatistics::summary() const {
+    QString res;
+    QTextStream stream(&res);
+    stream << QDateTime::currentDateTime().toString(Qt::ISODate)
+           << " session of " << milliseconds(m_sessionTimer.nsecsElapsed())
+           << " ms\n";
+    stream << "frames: " << m_paintTime.count
+           << ", pixels: " << m_pixels.total << "\n";
+    for (const QString &line: hudLines()) {
+        stream << line << "\n";
+    }
+    stream << "\n";
+    return res;
+}
+
+// saveSummary appends the summary of the session to the log in the cache
+// directory
+bool RenderStatistics::saveSummary() const {
+    QString path = QStandardPaths::writableLocation(
+                QStandardPaths::CacheLocation);
+    if (path.isEmpty() || !QDir().mkpath(path)) {
+        return false;
+    }
+    QFile file(QDir(path).filePath(SUMMARY_FILENAME));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        return false;
+    }
+    QTextStream(&file) << summary();
+    return true;
+}
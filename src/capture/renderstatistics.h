@@ -0,0 +1,72 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef RENDERSTATISTICS_H
+#define RENDERSTATISTICS_H
+
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QMap>
+
+class RenderStatistics
+{
+public:
+    RenderStatistics();
+
+    static bool isEnabled();
+
+    void inputReceived();
+    void addFrame(const qint64 paintTime, const qint64 pixels);
+    void addFrameInterval(const qint64 interval);
+    void addTemporalPaint(const qint64 time);
+    void addModificationPaint(const qint64 time);
+    void addToolCost(const QString &toolName, const qint64 time);
+    void setCaptureLatency(const qint64 grabTime, const qint64 firstFrame);
+
+    QStringList hudLines() const;
+    QString summary() const;
+    bool saveSummary() const;
+
+private:
+    // times in nanoseconds
+    struct Counter {
+        Counter();
+        void add(const qint64 value);
+        QString text() const;
+
+        int count;
+        qint64 total;
+        qint64 max;
+        qint64 last;
+    };
+
+    Counter m_paintTime;
+    Counter m_pixels;
+    Counter m_frameInterval;
+    Counter m_latency;
+    Counter m_temporalPaint;
+    Counter m_modificationPaint;
+    QMap<QString, Counter> m_toolCosts;
+    qint64 m_grabTime;
+    qint64 m_firstFrameLatency;
+
+    // time since the first input event not painted yet
+    QElapsedTimer m_inputTimer;
+    QElapsedTimer m_sessionTimer;
+};
+
+#endif // RENDERSTATISTICS_H
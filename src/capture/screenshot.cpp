@@ -19,91 +19,570 @@
 #include "src/capture/widget/capturebutton.h"
 #include "capturemodification.h"
 #include "src/capture/tools/capturetool.h"
+#include "src/capture/renderstatistics.h"
 #include "src/utils/filenamehandler.h"
 #include "src/utils/confighandler.h"
 #include <QMessageBox>
 #include <QImageWriter>
 #include <QFileDialog>
 #include <QPainter>
+#include <QtConcurrent>
+#include <QElapsedTimer>
+#include <QSet>
 #include <QBuffer>
 #include <QUrlQuery>
 #include <QNetworkRequest>
 #include <QNetworkAccessManager>
 
-// Screenshot is an extension of QPixmap which lets you manage specific tasks
+// Screenshot is an extension of QPixmap which lets you manage specific tasks.
+// The pixels are stored in a TiledImage, painting, cropping and drawing only
+// use the tiles they touch.
 
-Screenshot::Screenshot(const QPixmap &p, QObject *parent) : QObject(parent),
-    m_baseScreenshot(p),
-    m_modifiedScreenshot(p)
+namespace {
+
+const QColor OVERLAY_COLOR(0, 0, 0, 190);
+
+// number of modifications between two checkpoints, it bounds the
+// modifications replayed to undo a released patch
+const int CHECKPOINT_INTERVAL = 16;
+
+qint64 imageBytes(const QImage &image) {
+    return static_cast<qint64>(image.bytesPerLine()) * image.height();
+}
+
+// paintInTile draws the modification in a tile of the screenshot, tileRect
+// is the area of the tile in device pixels. The serial and the parallel
+// painting use it so both produce the same pixels.
+void paintInTile(QImage &tile, const QRect &tileRect, const qreal dpr,
+                 const CaptureModification &modification)
 {
+    QPainter painter(&tile);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.translate(-tileRect.topLeft());
+    painter.scale(dpr, dpr);
+    modification.tool()->processImage(painter, modification.points(),
+                                      modification.color(),
+                                      modification.thickness());
+}
+
+// tile of the screenshot replayed by a worker thread
+struct TileReplay {
+    int index;
+    QRect rect;
+    QImage image;
+    // indexes of the modifications covering the tile, in painting order
+    QVector<int> modifications;
+    // content of the tile before painting each modification
+    QVector<QImage> previous;
+};
+
+// tile held by the undo history, it's freed when the history doesn't
+// reference it
+struct TileReference {
+    TileReference() : count(0), bytes(0) {}
 
+    int count;
+    qint64 bytes;
+};
+
+void darkenTile(QImage &tile) {
+    QPainter painter(&tile);
+    painter.fillRect(tile.rect(), OVERLAY_COLOR);
+}
+
+} // unnamed namespace
+
+Screenshot::Screenshot(const TiledImage &image, QObject *parent) :
+    QObject(parent),
+    m_baseScreenshot(image),
+    m_modifiedScreenshot(m_baseScreenshot),
+    m_historySize(0),
+    m_temporalPointCount(0),
+    m_renderStatistics(nullptr)
+{
+    m_historyLimit = static_cast<qint64>(
+                ConfigHandler().undoMemoryLimitValue()) * 1024 * 1024;
+    m_darkScreenshot = m_baseScreenshot;
+    updateDarkTiles(m_baseScreenshot.tilesIntersecting(
+                        QRect(QPoint(0, 0), m_baseScreenshot.size())));
 }
 
 Screenshot::~Screenshot() {
 }
 
 void Screenshot::setScreenshot(const QPixmap &p) {
-    m_baseScreenshot = p;
-    m_modifiedScreenshot = p;
+    m_baseScreenshot = TiledImage(p.toImage());
+    m_modifiedScreenshot = m_baseScreenshot;
+    m_darkScreenshot = m_baseScreenshot;
+    clearHistory();
+    updateDarkTiles(m_baseScreenshot.tilesIntersecting(
+                        QRect(QPoint(0, 0), m_baseScreenshot.size())));
 }
 
 //  getScreenshot returns the screenshot with no modifications
 QPixmap Screenshot::baseScreenshot() const {
-    return m_baseScreenshot;
+    return QPixmap::fromImage(m_baseScreenshot.toImage());
 }
 
 //  getScreenshot returns the screenshot with all the modifications
 QPixmap Screenshot::screenshot() const {
-    return m_modifiedScreenshot;
+    return QPixmap::fromImage(m_modifiedScreenshot.toImage());
 }
 
+// croppedScreenshot returns the pixels of the selection (in device pixels)
 QPixmap Screenshot::croppedScreenshot(const QRect &selection) const {
-    return m_modifiedScreenshot.copy(selection);
+    return QPixmap::fromImage(m_modifiedScreenshot.copy(selection));
 }
 
-// paintModification adds a new modification to the screenshot
-QPixmap Screenshot::paintModification(const CaptureModification *modification) {
-    QPainter painter(&m_modifiedScreenshot);
-    painter.setRenderHint(QPainter::Antialiasing);
-    paintInPainter(painter, modification);
-    return m_modifiedScreenshot;
+qreal Screenshot::devicePixelRatio() const {
+    return m_modifiedScreenshot.devicePixelRatio();
+}
+
+// drawScreenshot draws the modified screenshot tiles covering the area (in
+// logical coordinates)
+void Screenshot::drawScreenshot(QPainter &painter, const QRect &area) const {
+    m_modifiedScreenshot.draw(painter, area);
+}
+
+// drawDarkScreenshot draws the modified screenshot darkened with the
+// overlay color, it is precomputed after each change of the screenshot
+void Screenshot::drawDarkScreenshot(QPainter &painter, const QRect &area) const {
+    m_darkScreenshot.draw(painter, area);
+}
+
+QColor Screenshot::overlayColor() {
+    return OVERLAY_COLOR;
 }
 
-// paintTemporalModification paints a modification without updating the
-// member pixmap
-QPixmap Screenshot::paintTemporalModification(
-        const CaptureModification *modification)
+// paintModification adds a new modification to the screenshot. Only the
+// tiles it covers are painted, their previous content is stored so the
+// modification can be undone with undoModification.
+void Screenshot::paintModification(const CaptureModification &modification) {
+    QElapsedTimer timer;
+    timer.start();
+    qint64 toolTime = 0;
+    qreal devicePixelRatio = m_modifiedScreenshot.devicePixelRatio();
+    Patch patch;
+    patch.size = 0;
+    patch.released = false;
+    patch.tiles = m_modifiedScreenshot.tilesIntersecting(
+                m_modifiedScreenshot.toDeviceRect(modification.boundingRect()));
+
+    for (const int index: patch.tiles) {
+        const QImage &previous = m_modifiedScreenshot.constTile(index);
+        // tiles shared with the base screenshot don't use extra memory
+        if (previous.cacheKey() != m_baseScreenshot.constTile(index).cacheKey()) {
+            patch.size += imageBytes(previous);
+        }
+        patch.pixels.append(previous);
+
+        QImage &tile = m_modifiedScreenshot.tile(index);
+        qint64 toolStart = timer.nsecsElapsed();
+        paintInTile(tile, m_modifiedScreenshot.tileRect(index),
+                    devicePixelRatio, modification);
+        toolTime += timer.nsecsElapsed() - toolStart;
+    }
+    updateDarkTiles(patch.tiles);
+    m_historySize += patch.size;
+    m_history.append(patch);
+    if (m_history.size() % CHECKPOINT_INTERVAL == 0) {
+        addCheckpoint();
+    }
+    releasePatches();
+    if (m_renderStatistics) {
+        m_renderStatistics->addToolCost(modification.tool()->name(), toolTime);
+        m_renderStatistics->addModificationPaint(timer.nsecsElapsed());
+    }
+}
+
+// paintTemporalModification renders the modification being drawn in a
+// transparent layer, without updating the screenshot, and returns the area
+// of the layer which changed. The path drawers only render the points added
+// since the previous call, the rest of the tools render the whole shape
+// again. The modification is added to the screenshot with paintModification.
+QRect Screenshot::paintTemporalModification(
+        const CaptureModification &modification)
 {
-    QPixmap tempPix(m_modifiedScreenshot);
-    QPainter painter(&tempPix);
-    if (modification->buttonType() != CaptureButton::TYPE_PENCIL) {
-        painter.setRenderHint(QPainter::Antialiasing);
+    QElapsedTimer timer;
+    timer.start();
+    const QVector<QPoint> &points = modification.points();
+    QRect damage;
+    if (modification.tool()->toolType() == CaptureTool::TYPE_PATH_DRAWER
+            && m_temporalPointCount > 0)
+    {
+        // the last rendered point could have been replaced by the
+        // simplification of the path
+        QVector<QPoint> segment;
+        segment << m_lastTemporalPoint;
+        for (int i = m_temporalPointCount - 1; i < points.size(); ++i) {
+            segment << points.at(i);
+        }
+        damage = modification.tool()->boundingRect(
+                    segment, modification.thickness());
+        paintTemporalPoints(modification, segment);
+    } else {
+        damage = m_temporalRect;
+        clearTemporalModification();
+        paintTemporalPoints(modification, points);
+        damage = damage.united(m_temporalRect);
+    }
+    m_temporalPointCount = points.size();
+    m_lastTemporalPoint = points.last();
+    if (m_renderStatistics) {
+        m_renderStatistics->addTemporalPaint(timer.nsecsElapsed());
     }
-    paintInPainter(painter, modification);
-    return tempPix;
+    return damage;
 }
 
-// paintBaseModifications overrides the modifications of the screenshot
-// with new ones.
-QPixmap Screenshot::overrideModifications(
-        const QVector<CaptureModification*> &m)
+// drawTemporalModification draws the tiles of the temporal layer covering
+// the area (in logical coordinates)
+void Screenshot::drawTemporalModification(QPainter &painter,
+                                          const QRect &area) const
 {
+    QRect deviceArea = m_modifiedScreenshot.toDeviceRect(area);
+    for (auto it = m_temporalTiles.constBegin();
+         it != m_temporalTiles.constEnd(); ++it)
+    {
+        if (m_modifiedScreenshot.tileRect(it.key()).intersects(deviceArea)) {
+            painter.drawImage(m_modifiedScreenshot.logicalTileRect(it.key()),
+                              it.value());
+        }
+    }
+}
+
+// temporalModificationRect returns the area painted in the temporal layer
+QRect Screenshot::temporalModificationRect() const {
+    return m_temporalRect;
+}
+
+void Screenshot::clearTemporalModification() {
+    m_temporalTiles.clear();
+    m_temporalRect = QRect();
+    m_temporalPointCount = 0;
+}
+
+// undoModification removes the last painted modification restoring the
+// tiles it covered. When they were released to respect the memory limit
+// the remaining modifications are replayed from the nearest checkpoint.
+void Screenshot::undoModification(
+        const QVector<CaptureModification> &remaining)
+{
+    if (m_history.isEmpty()) {
+        return;
+    }
+    Patch patch = m_history.takeLast();
+    // the checkpoints taken after the undone modification are obsolete
+    while (!m_checkpoints.isEmpty()
+           && m_checkpoints.last().modifications > m_history.size())
+    {
+        m_historySize -= m_checkpoints.last().size;
+        m_checkpoints.removeLast();
+    }
+    if (patch.released) {
+        replayFromCheckpoint(remaining);
+    } else {
+        m_historySize -= patch.size;
+        for (int i = 0; i < patch.tiles.size(); ++i) {
+            m_modifiedScreenshot.setTile(patch.tiles.at(i), patch.pixels.at(i));
+        }
+        updateDarkTiles(patch.tiles);
+    }
+}
+
+// overrideModifications rebuilds the screenshot from the base one with the
+// passed modifications. The tiles are independent so they are replayed in
+// parallel, each tile only paints the modifications covering it in their
+// original order, which gives the same result as painting them one by one.
+// The previous content of the tiles is kept to rebuild the undo history.
+void Screenshot::overrideModifications(
+        const QVector<CaptureModification> &m)
+{
+    // the dark tiles of the painted tiles have to be reset
+    QVector<int> paintedTiles;
+    for (int i = 0; i < m_modifiedScreenshot.tileCount(); ++i) {
+        if (m_modifiedScreenshot.constTile(i).cacheKey()
+                != m_baseScreenshot.constTile(i).cacheKey())
+        {
+            paintedTiles << i;
+        }
+    }
     m_modifiedScreenshot = m_baseScreenshot;
-    for (const CaptureModification *const modification: m) {
-        paintModification(modification);
+    clearHistory();
+
+    QVector<TileReplay> replays;
+    QHash<int, int> replayOfTile;
+    for (int i = 0; i < m.size(); ++i) {
+        QVector<int> tiles = m_modifiedScreenshot.tilesIntersecting(
+                    m_modifiedScreenshot.toDeviceRect(m.at(i).boundingRect()));
+        for (const int index: tiles) {
+            auto it = replayOfTile.constFind(index);
+            if (it == replayOfTile.constEnd()) {
+                TileReplay replay;
+                replay.index = index;
+                replay.rect = m_modifiedScreenshot.tileRect(index);
+                replay.image = m_modifiedScreenshot.constTile(index);
+                it = replayOfTile.insert(index, replays.size());
+                replays.append(replay);
+            }
+            replays[it.value()].modifications.append(i);
+        }
+    }
+
+    const qreal dpr = m_modifiedScreenshot.devicePixelRatio();
+    QtConcurrent::blockingMap(replays, [&m, dpr](TileReplay &replay) {
+        for (const int i: replay.modifications) {
+            replay.previous.append(replay.image);
+            paintInTile(replay.image, replay.rect, dpr, m.at(i));
+        }
+    });
+
+    m_history.resize(m.size());
+    for (Patch &patch: m_history) {
+        patch.size = 0;
+        patch.released = false;
+    }
+    for (const TileReplay &replay: replays) {
+        m_modifiedScreenshot.setTile(replay.index, replay.image);
+        if (!paintedTiles.contains(replay.index)) {
+            paintedTiles << replay.index;
+        }
+        const QImage &base = m_baseScreenshot.constTile(replay.index);
+        for (int j = 0; j < replay.modifications.size(); ++j) {
+            Patch &patch = m_history[replay.modifications.at(j)];
+            const QImage &previous = replay.previous.at(j);
+            patch.tiles.append(replay.index);
+            patch.pixels.append(previous);
+            // tiles shared with the base screenshot don't use extra memory
+            if (previous.cacheKey() != base.cacheKey()) {
+                patch.size += imageBytes(previous);
+            }
+        }
+    }
+    for (const Patch &patch: m_history) {
+        m_historySize += patch.size;
+    }
+
+    // the checkpoints are built from the content of the tiles before
+    // painting the first modification after them
+    for (int count = CHECKPOINT_INTERVAL; count <= m.size();
+         count += CHECKPOINT_INTERVAL)
+    {
+        Checkpoint checkpoint;
+        checkpoint.modifications = count;
+        checkpoint.image = m_baseScreenshot;
+        for (const TileReplay &replay: replays) {
+            int j = 0;
+            while (j < replay.modifications.size()
+                   && replay.modifications.at(j) < count) {
+                ++j;
+            }
+            if (j == replay.modifications.size()) {
+                checkpoint.image.setTile(replay.index, replay.image);
+            } else if (j > 0) {
+                checkpoint.image.setTile(replay.index, replay.previous.at(j));
+            }
+        }
+        checkpoint.size = paintedSize(checkpoint.image);
+        m_historySize += checkpoint.size;
+        m_checkpoints.append(checkpoint);
     }
-    return m_modifiedScreenshot;
+    releasePatches();
+    updateDarkTiles(paintedTiles);
 }
 
-// paintInPainter is an aux method to prevent duplicated code, it draws the
-// passed modification to the painter.
-void Screenshot::paintInPainter(QPainter &painter,
-                                const CaptureModification *modification)
+void Screenshot::setRenderStatistics(RenderStatistics *statistics) {
+    m_renderStatistics = statistics;
+}
+
+// paintTemporalPoints paints the points with the tool of the modification in
+// the tiles of the temporal layer they cover. The pencil is not antialiased
+// while drawing for performance.
+void Screenshot::paintTemporalPoints(const CaptureModification &modification,
+                                     const QVector<QPoint> &points)
 {
-    const QVector<QPoint> &points = modification->points();
-    QColor color = modification->color();
-    int thickness = modification->thickness();
-    modification->tool()->processImage(painter, points, color, thickness);
+    const CaptureTool *tool = modification.tool();
+    QRect area = tool->boundingRect(points, modification.thickness());
+    m_temporalRect = m_temporalRect.united(area);
+
+    qreal devicePixelRatio = m_modifiedScreenshot.devicePixelRatio();
+    QVector<int> tiles = m_modifiedScreenshot.tilesIntersecting(
+                m_modifiedScreenshot.toDeviceRect(area));
+    QElapsedTimer timer;
+    qint64 toolTime = 0;
+    for (const int index: tiles) {
+        QRect tileRect = m_modifiedScreenshot.tileRect(index);
+        QImage &tile = m_temporalTiles[index];
+        if (tile.isNull()) {
+            tile = QImage(tileRect.size(), QImage::Format_ARGB32_Premultiplied);
+            tile.fill(Qt::transparent);
+        }
+        QPainter painter(&tile);
+        if (modification.buttonType() != CaptureButton::TYPE_PENCIL) {
+            painter.setRenderHint(QPainter::Antialiasing);
+        }
+        painter.translate(-tileRect.topLeft());
+        painter.scale(devicePixelRatio, devicePixelRatio);
+        timer.start();
+        tool->processImage(painter, points, modification.color(),
+                           modification.thickness());
+        toolTime += timer.nsecsElapsed();
+    }
+    if (m_renderStatistics) {
+        m_renderStatistics->addToolCost(tool->name(), toolTime);
+    }
 }
 
+// addCheckpoint stores the current state of the modified screenshot, its
+// tiles are shared with it until they are painted again
+void Screenshot::addCheckpoint() {
+    Checkpoint checkpoint;
+    checkpoint.modifications = m_history.size();
+    checkpoint.image = m_modifiedScreenshot;
+    checkpoint.size = paintedSize(checkpoint.image);
+    m_historySize += checkpoint.size;
+    m_checkpoints.append(checkpoint);
+}
 
+// replayFromCheckpoint rebuilds the screenshot painting the remaining
+// modifications over the nearest checkpoint, or over the base screenshot
+// when there is none, so an undo never replays more than
+// CHECKPOINT_INTERVAL modifications while the checkpoints fit in the
+// memory limit
+void Screenshot::replayFromCheckpoint(
+        const QVector<CaptureModification> &remaining)
+{
+    const TiledImage previous = m_modifiedScreenshot;
+    int first = 0;
+    if (m_checkpoints.isEmpty()) {
+        m_modifiedScreenshot = m_baseScreenshot;
+    } else {
+        m_modifiedScreenshot = m_checkpoints.last().image;
+        first = m_checkpoints.last().modifications;
+    }
+    const qreal dpr = m_modifiedScreenshot.devicePixelRatio();
+    for (int i = first; i < remaining.size(); ++i) {
+        const CaptureModification &modification = remaining.at(i);
+        for (const int index: m_modifiedScreenshot.tilesIntersecting(
+                 m_modifiedScreenshot.toDeviceRect(
+                     modification.boundingRect())))
+        {
+            paintInTile(m_modifiedScreenshot.tile(index),
+                        m_modifiedScreenshot.tileRect(index), dpr,
+                        modification);
+        }
+    }
+    QVector<int> changedTiles;
+    for (int i = 0; i < m_modifiedScreenshot.tileCount(); ++i) {
+        if (m_modifiedScreenshot.constTile(i).cacheKey()
+                != previous.constTile(i).cacheKey())
+        {
+            changedTiles << i;
+        }
+    }
+    updateDarkTiles(changedTiles);
+}
+
+// paintedSize returns the memory used by the tiles of the image which
+// aren't shared with the base screenshot nor with the modified one, a
+// checkpoint taken now doesn't use extra memory
+qint64 Screenshot::paintedSize(const TiledImage &image) const {
+    qint64 size = 0;
+    for (int i = 0; i < image.tileCount(); ++i) {
+        const qint64 key = image.constTile(i).cacheKey();
+        if (key != m_baseScreenshot.constTile(i).cacheKey()
+                && key != m_modifiedScreenshot.constTile(i).cacheKey())
+        {
+            size += imageBytes(image.constTile(i));
+        }
+    }
+    return size;
+}
+
+// releasePatches frees the oldest patches until the history fits in the
+// memory limit, the last patch is always kept. When the checkpoints alone
+// exceed the limit the oldest ones are dropped too, keeping the last one.
+// The sizes of the patches and the checkpoints are an upper bound since
+// they can share tiles, so the memory held by the history is counted
+// before releasing anything and replaces the estimate.
+void Screenshot::releasePatches() {
+    if (m_historySize <= m_historyLimit) {
+        return;
+    }
+    QSet<qint64> usedTiles;
+    for (int i = 0; i < m_modifiedScreenshot.tileCount(); ++i) {
+        usedTiles << m_modifiedScreenshot.constTile(i).cacheKey()
+                  << m_baseScreenshot.constTile(i).cacheKey();
+    }
+    QHash<qint64, TileReference> references;
+    qint64 size = 0;
+    auto reference = [&](const QImage &tile) {
+        const qint64 key = tile.cacheKey();
+        if (usedTiles.contains(key)) {
+            return;
+        }
+        TileReference &r = references[key];
+        if (r.count++ == 0) {
+            r.bytes = imageBytes(tile);
+            size += r.bytes;
+        }
+    };
+    auto release = [&](const QImage &tile) {
+        auto it = references.find(tile.cacheKey());
+        if (it != references.end() && --it->count == 0) {
+            size -= it->bytes;
+        }
+    };
+    for (const Patch &patch: m_history) {
+        for (const QImage &tile: patch.pixels) {
+            reference(tile);
+        }
+    }
+    for (const Checkpoint &checkpoint: m_checkpoints) {
+        for (int i = 0; i < checkpoint.image.tileCount(); ++i) {
+            reference(checkpoint.image.constTile(i));
+        }
+    }
+
+    for (int i = 0; i < m_history.size() - 1 && size > m_historyLimit; ++i) {
+        Patch &patch = m_history[i];
+        if (!patch.released) {
+            for (const QImage &tile: patch.pixels) {
+                release(tile);
+            }
+            patch.pixels.clear();
+            patch.released = true;
+        }
+    }
+    while (m_checkpoints.size() > 1 && size > m_historyLimit) {
+        const TiledImage &image = m_checkpoints.first().image;
+        for (int i = 0; i < image.tileCount(); ++i) {
+            release(image.constTile(i));
+        }
+        m_checkpoints.removeFirst();
+    }
+    m_historySize = size;
+}
+
+// updateDarkTiles recomputes the dark version of the tiles, they are
+// darkened in parallel when there is more than one
+void Screenshot::updateDarkTiles(const QVector<int> &tiles) {
+    QVector<QImage> darkTiles;
+    darkTiles.reserve(tiles.size());
+    for (const int index: tiles) {
+        darkTiles.append(m_modifiedScreenshot.constTile(index));
+    }
+    if (darkTiles.size() > 1) {
+        QtConcurrent::blockingMap(darkTiles, darkenTile);
+    } else if (!darkTiles.isEmpty()) {
+        darkenTile(darkTiles.first());
+    }
+    for (int i = 0; i < tiles.size(); ++i) {
+        m_darkScreenshot.setTile(tiles.at(i), darkTiles.at(i));
+    }
+}
+
+void Screenshot::clearHistory() {
+    m_history.clear();
+    m_checkpoints.clear();
+    m_historySize = 0;
+}
@@ -18,35 +18,97 @@
 #ifndef SCREENSHOT_H
 #define SCREENSHOT_H
 
+#include "src/capture/tiledimage.h"
 #include <QPixmap>
 #include <QRect>
 #include <QPointer>
 #include <QObject>
+#include <QVector>
+#include <QHash>
 
 class QString;
 class CaptureModification;
+class RenderStatistics;
 class QNetworkAccessManager;
 
 class Screenshot : public QObject {
    Q_OBJECT
 public:
-    Screenshot(const QPixmap &, QObject *parent = nullptr);
+    Screenshot(const TiledImage &, QObject *parent = nullptr);
     ~Screenshot();
 
     void setScreenshot(const QPixmap &);
     QPixmap baseScreenshot() const;
     QPixmap screenshot() const;
     QPixmap croppedScreenshot(const QRect &selection) const;
+    qreal devicePixelRatio() const;
+    void drawScreenshot(QPainter &, const QRect &area) const;
+    void drawDarkScreenshot(QPainter &, const QRect &area) const;
+    static QColor overlayColor();
 
-    QPixmap paintModification(const CaptureModification*);
-    QPixmap paintTemporalModification(const CaptureModification*);
-    QPixmap overrideModifications(const QVector<CaptureModification*> &);
+    void paintModification(const CaptureModification &);
+    QRect paintTemporalModification(const CaptureModification &);
+    void drawTemporalModification(QPainter &, const QRect &area) const;
+    QRect temporalModificationRect() const;
+    void clearTemporalModification();
+    void undoModification(const QVector<CaptureModification> &);
+    void overrideModifications(const QVector<CaptureModification> &);
+
+    void setRenderStatistics(RenderStatistics *);
 
 private:
-    QPixmap m_baseScreenshot;
-    QPixmap m_modifiedScreenshot;
+    // tiles of the modified screenshot before painting a committed
+    // modification
+    struct Patch {
+        QVector<int> tiles;
+        QVector<QImage> pixels;
+        qint64 size;
+        bool released;
+    };
+
+    // copy of the modified screenshot after a number of modifications, the
+    // released patches are undone by replaying from the nearest one
+    struct Checkpoint {
+        int modifications;
+        TiledImage image;
+        qint64 size;
+    };
+
+    // the modified screenshot shares the tiles of the base one which
+    // haven't been painted
+    TiledImage m_baseScreenshot;
+    TiledImage m_modifiedScreenshot;
+    // modified screenshot darkened with the overlay color, shown outside of
+    // the selection
+    TiledImage m_darkScreenshot;
+
+    // one patch per committed modification, the oldest ones are released
+    // when the memory limit is exceeded
+    QVector<Patch> m_history;
+    // one checkpoint every CHECKPOINT_INTERVAL modifications, their memory
+    // is counted in the history size
+    QVector<Checkpoint> m_checkpoints;
+    qint64 m_historySize;
+    qint64 m_historyLimit;
+
+    // transparent layer with the modification being drawn, its tiles are
+    // created when they are painted
+    QHash<int, QImage> m_temporalTiles;
+    QRect m_temporalRect;
+    int m_temporalPointCount;
+    QPoint m_lastTemporalPoint;
+
+    // measures the painting time when it is set
+    RenderStatistics *m_renderStatistics;
 
-    void paintInPainter(QPainter &, const CaptureModification *);
+    void paintTemporalPoints(const CaptureModification &,
+                             const QVector<QPoint> &points);
+    void addCheckpoint();
+    void replayFromCheckpoint(const QVector<CaptureModification> &);
+    qint64 paintedSize(const TiledImage &) const;
+    void releasePatches();
+    void updateDarkTiles(const QVector<int> &tiles);
+    void clearHistory();
 
 };
 
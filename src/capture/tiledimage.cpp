@@ -0,0 +1,235 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "tiledimage.h"
+#include <QPainter>
+#include <QtConcurrent>
+
+// TiledImage stores an image as a grid of tiles of TILE_SIZE pixels. The
+// tiles are implicitly shared between copies of a TiledImage, painting in
+// one of them only duplicates the tiles which are painted.
+// Rects are in device pixels unless the opposite is indicated.
+
+TiledImage::TiledImage() :
+    m_devicePixelRatio(1), m_format(QImage::Format_RGB32), m_columns(0)
+{
+
+}
+
+TiledImage::TiledImage(const QImage &image) :
+    m_size(image.size()),
+    m_devicePixelRatio(image.devicePixelRatio())
+{
+    // the tiles must be opaque when the image is, a PNG with an
+    // alpha channel would be exported otherwise
+    m_format = image.hasAlphaChannel() ?
+                QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32;
+    QImage source = image.convertToFormat(m_format);
+    m_areas << QRect(QPoint(0, 0), m_size);
+
+    m_columns = (m_size.width() + TILE_SIZE - 1) / TILE_SIZE;
+    int rows = (m_size.height() + TILE_SIZE - 1) / TILE_SIZE;
+    m_tiles.reserve(m_columns * rows);
+    for (int i = 0; i < m_columns * rows; ++i) {
+        QImage tile = source.copy(tileRect(i));
+        tile.setDevicePixelRatio(1);
+        m_tiles.append(tile);
+    }
+}
+
+// TiledImage composes the sources in an opaque image, only the tiles
+// covered by a source are stored. The sources are scaled when their size is
+// different from the one of their rect. The tiles are composed in parallel.
+TiledImage::TiledImage(const QSize &size, const qreal devicePixelRatio,
+                       const QVector<Source> &sources) :
+    m_size(size),
+    m_devicePixelRatio(devicePixelRatio),
+    m_format(QImage::Format_RGB32)
+{
+    m_columns = (m_size.width() + TILE_SIZE - 1) / TILE_SIZE;
+    int rows = (m_size.height() + TILE_SIZE - 1) / TILE_SIZE;
+    m_tiles.resize(m_columns * rows);
+
+    QVector<int> covered;
+    QVector<bool> isCovered(m_tiles.size(), false);
+    for (const Source &source: sources) {
+        m_areas << source.rect.intersected(QRect(QPoint(0, 0), m_size));
+        for (const int index: tileIndexes(source.rect)) {
+            if (!isCovered.at(index)) {
+                isCovered[index] = true;
+                covered << index;
+            }
+        }
+    }
+
+    // each thread writes different tiles
+    QImage *tiles = m_tiles.data();
+    QtConcurrent::blockingMap(covered, [this, tiles, &sources](int &index) {
+        QRect rect = tileRect(index);
+        QImage tile(rect.size(), m_format);
+        tile.fill(Qt::black);
+        QPainter painter(&tile);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform);
+        painter.translate(-rect.topLeft());
+        for (const Source &source: sources) {
+            QRect target = source.rect.intersected(rect);
+            if (target.isEmpty() || source.image.isNull()) {
+                continue;
+            }
+            qreal sx = source.image.width() / qreal(source.rect.width());
+            qreal sy = source.image.height() / qreal(source.rect.height());
+            QRectF sourceRect((target.x() - source.rect.x()) * sx,
+                              (target.y() - source.rect.y()) * sy,
+                              target.width() * sx, target.height() * sy);
+            painter.drawImage(QRectF(target), source.image, sourceRect);
+        }
+        painter.end();
+        tiles[index] = tile;
+    });
+}
+
+bool TiledImage::isNull() const {
+    return m_tiles.isEmpty();
+}
+
+QSize TiledImage::size() const {
+    return m_size;
+}
+
+// areas returns the areas of the image with pixels, the whole image unless
+// it was composed from sources
+QVector<QRect> TiledImage::areas() const {
+    return m_areas;
+}
+
+qreal TiledImage::devicePixelRatio() const {
+    return m_devicePixelRatio;
+}
+
+// toDeviceRect maps a rect in logical coordinates to the device pixels it
+// covers
+QRect TiledImage::toDeviceRect(const QRect &logicalRect) const {
+    return QRectF(logicalRect.x() * m_devicePixelRatio,
+                  logicalRect.y() * m_devicePixelRatio,
+                  logicalRect.width() * m_devicePixelRatio,
+                  logicalRect.height() * m_devicePixelRatio).toAlignedRect();
+}
+
+int TiledImage::tileCount() const {
+    return m_tiles.size();
+}
+
+QRect TiledImage::tileRect(const int index) const {
+    QRect r((index % m_columns) * TILE_SIZE, (index / m_columns) * TILE_SIZE,
+            TILE_SIZE, TILE_SIZE);
+    return r.intersected(QRect(QPoint(0, 0), m_size));
+}
+
+// logicalTileRect returns the area covered by the tile in logical
+// coordinates
+QRectF TiledImage::logicalTileRect(const int index) const {
+    QRect r = tileRect(index);
+    return QRectF(r.x() / m_devicePixelRatio, r.y() / m_devicePixelRatio,
+                  r.width() / m_devicePixelRatio,
+                  r.height() / m_devicePixelRatio);
+}
+
+// tilesIntersecting returns the indexes of the stored tiles which contain
+// pixels of the rect
+QVector<int> TiledImage::tilesIntersecting(const QRect &rect) const {
+    QVector<int> res;
+    for (const int index: tileIndexes(rect)) {
+        if (!m_tiles.at(index).isNull()) {
+            res.append(index);
+        }
+    }
+    return res;
+}
+
+// tileIndexes returns the indexes of the tiles in the rect, stored or not
+QVector<int> TiledImage::tileIndexes(const QRect &rect) const {
+    QVector<int> res;
+    QRect r = rect.normalized().intersected(QRect(QPoint(0, 0), m_size));
+    if (r.isEmpty()) {
+        return res;
+    }
+    for (int row = r.top() / TILE_SIZE; row <= r.bottom() / TILE_SIZE; ++row) {
+        for (int col = r.left() / TILE_SIZE; col <= r.right() / TILE_SIZE; ++col) {
+            res.append(row * m_columns + col);
+        }
+    }
+    return res;
+}
+
+const QImage &TiledImage::constTile(const int index) const {
+    return m_tiles.at(index);
+}
+
+// tile returns a modifiable tile, painting in it detaches it from the
+// copies of this image
+QImage &TiledImage::tile(const int index) {
+    return m_tiles[index];
+}
+
+void TiledImage::setTile(const int index, const QImage &tile) {
+    m_tiles[index] = tile;
+}
+
+// copy composes the tiles covering the rect in a new image
+QImage TiledImage::copy(const QRect &rect) const {
+    QRect r = rect.normalized();
+    if (isNull() || r.isEmpty()) {
+        return QImage();
+    }
+    QImage res(r.size(), m_format);
+    res.fill(Qt::transparent);
+    QPainter painter(&res);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    for (const int index: tilesIntersecting(r)) {
+        painter.drawImage(tileRect(index).topLeft() - r.topLeft(),
+                          m_tiles.at(index));
+    }
+    painter.end();
+    res.setDevicePixelRatio(m_devicePixelRatio);
+    return res;
+}
+
+// copyTo composes the whole image in the target, which must have its size.
+// It lets reuse an image instead of allocating a new one.
+void TiledImage::copyTo(QImage &target) const {
+    QPainter painter(&target);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    for (int index = 0; index < m_tiles.size(); ++index) {
+        const QImage &tile = m_tiles.at(index);
+        if (tile.isNull()) {
+            painter.fillRect(tileRect(index), Qt::black);
+        } else {
+            painter.drawImage(tileRect(index).topLeft(), tile);
+        }
+    }
+}
+
+QImage TiledImage::toImage() const {
+    return copy(QRect(QPoint(0, 0), m_size));
+}
+
+// draw paints the tiles covering a rect in logical coordinates
+void TiledImage::draw(QPainter &painter, const QRect &logicalRect) const {
+    for (const int index: tilesIntersecting(toDeviceRect(logicalRect))) {
+        painter.drawImage(logicalTileRect(index), m_tiles.at(index));
+    }
+}
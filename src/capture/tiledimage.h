@@ -0,0 +1,75 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TILEDIMAGE_H
+#define TILEDIMAGE_H
+
+#include <QImage>
+#include <QVector>
+#include <QRect>
+
+class QPainter;
+
+class TiledImage {
+public:
+    static const int TILE_SIZE = 256;
+
+    // image drawn in an area of a composed TiledImage
+    struct Source {
+        QRect rect;
+        QImage image;
+    };
+
+    TiledImage();
+    explicit TiledImage(const QImage &image);
+    TiledImage(const QSize &size, const qreal devicePixelRatio,
+               const QVector<Source> &sources);
+
+    bool isNull() const;
+    QSize size() const;
+    QVector<QRect> areas() const;
+    qreal devicePixelRatio() const;
+    QRect toDeviceRect(const QRect &logicalRect) const;
+
+    int tileCount() const;
+    QRect tileRect(const int index) const;
+    QRectF logicalTileRect(const int index) const;
+    QVector<int> tilesIntersecting(const QRect &rect) const;
+
+    const QImage &constTile(const int index) const;
+    QImage &tile(const int index);
+    void setTile(const int index, const QImage &tile);
+
+    QImage copy(const QRect &rect) const;
+    void copyTo(QImage &target) const;
+    QImage toImage() const;
+    void draw(QPainter &painter, const QRect &logicalRect) const;
+
+private:
+    QSize m_size;
+    qreal m_devicePixelRatio;
+    QImage::Format m_format;
+    int m_columns;
+    // the tiles out of the areas are null
+    QVector<QImage> m_tiles;
+    QVector<QRect> m_areas;
+
+    QVector<int> tileIndexes(const QRect &rect) const;
+
+};
+
+#endif // TILEDIMAGE_H
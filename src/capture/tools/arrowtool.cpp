@@ -89,12 +89,20 @@ void ArrowTool::processImage(
         QPainter &painter,
         const QVector<QPoint> &points,
         const QColor &color,
-        const int thickness)
+        const int thickness) const
 {
     painter.setPen(QPen(color, 2 + thickness));
     painter.drawLine(getShorterLine(points[0], points[1], thickness));
     painter.fillPath(getArrowHead(points[0], points[1], thickness), QBrush(color));
 }
 
+// the arrow head is wider than the pen
+QRect ArrowTool::boundingRect(
+        const QVector<QPoint> &points,
+        const int thickness) const
+{
+    return CaptureTool::boundingRect(points, ArrowWidth + thickness);
+}
+
 void ArrowTool::onPressed() {
 }
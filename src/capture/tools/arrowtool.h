@@ -38,7 +38,11 @@ public:
             QPainter &painter,
             const QVector<QPoint> &points,
             const QColor &color,
-            const int thickness) override;
+            const int thickness) const override;
+
+    QRect boundingRect(
+            const QVector<QPoint> &points,
+            const int thickness) const override;
 
     void onPressed() override;
 
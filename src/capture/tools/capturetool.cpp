@@ -16,7 +16,23 @@
 //     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "capturetool.h"
+#include <QPolygon>
 
 CaptureTool::CaptureTool(QObject *parent) : QObject(parent)
 {
 }
+
+// boundingRect returns the area touched by processImage for the given points
+// and thickness. The default covers shapes drawn along the points with a pen
+// of width 2 + thickness, tools painting outside of it have to override it.
+QRect CaptureTool::boundingRect(
+        const QVector<QPoint> &points,
+        const int thickness) const
+{
+    if (points.isEmpty()) {
+        return QRect();
+    }
+    int margin = thickness + 2;
+    return QPolygon(points).boundingRect()
+            .adjusted(-margin, -margin, margin, margin);
+}
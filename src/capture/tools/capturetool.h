@@ -20,6 +20,7 @@
 
 #include <QObject>
 #include <QVector>
+#include <QRect>
 
 class QPainter;
 
@@ -61,7 +62,11 @@ public:
             QPainter &painter,
             const QVector<QPoint> &points,
             const QColor &color,
-            const int thickness) = 0;
+            const int thickness) const = 0;
+
+    virtual QRect boundingRect(
+            const QVector<QPoint> &points,
+            const int thickness) const;
 
 signals:
     void requestAction(Request r);
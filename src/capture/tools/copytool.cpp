@@ -50,7 +50,7 @@ void CopyTool::processImage(
         QPainter &painter,
         const QVector<QPoint> &points,
         const QColor &color,
-        const int thickness)
+        const int thickness) const
 {
     Q_UNUSED(painter);
     Q_UNUSED(points);
@@ -52,7 +52,7 @@ void LineTool::processImage(
         QPainter &painter,
         const QVector<QPoint> &points,
         const QColor &color,
-        const int thickness)
+        const int thickness) const
 {
     QPoint p0 = points[0];
     QPoint p1 = points[1];
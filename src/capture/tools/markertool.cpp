@@ -52,7 +52,7 @@ void MarkerTool::processImage(
         QPainter &painter,
         const QVector<QPoint> &points,
         const QColor &color,
-        const int thickness)
+        const int thickness) const
 {
     QPoint p0 = points[0];
     QPoint p1 = points[1];
@@ -65,6 +65,14 @@ void MarkerTool::processImage(
     painter.setOpacity(1);
 }
 
+// the marker pen is 12 pixels wider than the base one
+QRect MarkerTool::boundingRect(
+        const QVector<QPoint> &points,
+        const int thickness) const
+{
+    return CaptureTool::boundingRect(points, 12 + thickness);
+}
+
 void MarkerTool::onPressed() {
 }
 
@@ -50,9 +50,11 @@ void PencilTool::processImage(
         QPainter &painter,
         const QVector<QPoint> &points,
         const QColor &color,
-        const int thickness)
+        const int thickness) const
 {
-    painter.setPen(QPen(color, 2 + thickness));
+    // round caps and joins, the path is rendered in pieces while drawing
+    painter.setPen(QPen(color, 2 + thickness, Qt::SolidLine,
+                        Qt::RoundCap, Qt::RoundJoin));
     painter.drawPolyline(points.data(), points.size());
 }
 
@@ -50,7 +50,7 @@ void RectangleTool::processImage(
         QPainter &painter,
         const QVector<QPoint> &points,
         const QColor &color,
-        const int thickness)
+        const int thickness) const
 {
     painter.setPen(QPen(color, 2  + thickness));
     painter.setBrush(QBrush(color));
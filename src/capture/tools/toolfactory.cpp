@@ -30,6 +30,20 @@
 #include "selectiontool.h"
 #include "sizeindicatortool.h"
 #include "undotool.h"
+#include <QCoreApplication>
+
+namespace {
+
+// a single instance of every tool is created the first time it is needed.
+// The instances are children of the application so they are destroyed with
+// it instead of during the static destruction, after it.
+template <class T>
+const CaptureTool* sharedInstance() {
+    static const T *tool = new T(qApp);
+    return tool;
+}
+
+} // unnamed namespace
 
 ToolFactory::ToolFactory(QObject *parent) : QObject(parent)
 {
@@ -90,3 +104,58 @@ CaptureTool* ToolFactory::CreateTool(
     }
     return tool;
 }
+
+// sharedTool returns the instance of the tool shared by all the
+// modifications of a type. The tools are stateless, it must only be used to
+// render them, the buttons create their own tools with CreateTool.
+const CaptureTool* ToolFactory::sharedTool(CaptureButton::ButtonType t) {
+    const CaptureTool *tool;
+    switch (t) {
+    case CaptureButton::TYPE_ARROW:
+        tool = sharedInstance<ArrowTool>();
+        break;
+    case CaptureButton::TYPE_CIRCLE:
+        tool = sharedInstance<CircleTool>();
+        break;
+    case CaptureButton::TYPE_COPY:
+        tool = sharedInstance<CopyTool>();
+        break;
+    case CaptureButton::TYPE_EXIT:
+        tool = sharedInstance<ExitTool>();
+        break;
+    case CaptureButton::TYPE_IMAGEUPLOADER:
+        tool = sharedInstance<ImgurUploaderTool>();
+        break;
+    case CaptureButton::TYPE_LINE:
+        tool = sharedInstance<LineTool>();
+        break;
+    case CaptureButton::TYPE_MARKER:
+        tool = sharedInstance<MarkerTool>();
+        break;
+    case CaptureButton::TYPE_MOVESELECTION:
+        tool = sharedInstance<MoveTool>();
+        break;
+    case CaptureButton::TYPE_PENCIL:
+        tool = sharedInstance<PencilTool>();
+        break;
+    case CaptureButton::TYPE_RECTANGLE:
+        tool = sharedInstance<RectangleTool>();
+        break;
+    case CaptureButton::TYPE_SAVE:
+        tool = sharedInstance<SaveTool>();
+        break;
+    case CaptureButton::TYPE_SELECTION:
+        tool = sharedInstance<SelectionTool>();
+        break;
+    case CaptureButton::TYPE_SELECTIONINDICATOR:
+        tool = sharedInstance<SizeIndicatorTool>();
+        break;
+    case CaptureButton::TYPE_UNDO:
+        tool = sharedInstance<UndoTool>();
+        break;
+    default:
+        tool = nullptr;
+        break;
+    }
+    return tool;
+}
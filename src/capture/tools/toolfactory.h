@@ -42,6 +42,8 @@ public:
             CaptureButton::ButtonType t,
             QObject *parent = nullptr);
 
+    static const CaptureTool* sharedTool(CaptureButton::ButtonType t);
+
 };
 
 #endif // TOOLFACTORY_H
@@ -23,10 +23,12 @@
 
 #include "src/capture/screenshot.h"
 #include "src/capture/capturemodification.h"
+#include "src/capture/renderstatistics.h"
 #include "capturewidget.h"
 #include "capturebutton.h"
 #include "src/capture/widget/notifierbox.h"
 #include "src/capture/widget/colorpicker.h"
+#include "src/capture/widget/repaintscheduler.h"
 #include "src/utils/screengrabber.h"
 #include "src/utils/confighandler.h"
 #include "src/utils/systemnotification.h"
@@ -38,6 +40,7 @@
 #include <QPainter>
 #include <QPaintEvent>
 #include <QMouseEvent>
+#include <QElapsedTimer>
 
 // CaptureWidget is the main component used to capture the screen. It contains an
 // are of selection with its respective buttons.
@@ -46,21 +49,20 @@ namespace {
 
 // size of the handlers at the corners of the selection
 const int HANDLE_SIZE = 9;
+// width of the box with the rendering statistics
+const int STATISTICS_WIDTH = 360;
 
 } // unnamed namespace
 
-// enableSaveWIndow
-CaptureWidget::CaptureWidget(const QString &forcedSavePath, QWidget *parent) :
-    QWidget(parent), m_mouseOverHandle(0), m_mouseIsClicked(false),
-    m_rightClick(false), m_newSelection(false), m_grabbing(false),
-    m_forcedSavePath(forcedSavePath),
+// CaptureWidget is created in advance and reused, startCapture grabs the
+// screens and shows it.
+CaptureWidget::CaptureWidget(QWidget *parent) :
+    QWidget(parent), m_screenshot(nullptr), m_mouseOverHandle(0),
+    m_mouseIsClicked(false), m_rightClick(false), m_newSelection(false),
+    m_grabbing(false), m_temporalModificationPending(false),
+    m_renderStatistics(nullptr), m_firstFramePainted(true),
     m_state(CaptureButton::TYPE_MOVESELECTION)
 {
-    ConfigHandler config;
-    m_showInitialMsg = config.showHelpValue();
-    m_thickness = config.drawThicknessValue();
-
-    setAttribute(Qt::WA_DeleteOnClose);
     // create selection handlers
     QRect baseRect(0, 0, HANDLE_SIZE, HANDLE_SIZE);
     m_TLHandle = baseRect; m_TRHandle = baseRect;
@@ -78,32 +80,123 @@ CaptureWidget::CaptureWidget(const QString &forcedSavePath, QWidget *parent) :
                    | Qt::Tool);
 
     setMouseTracking(true);
+    // the input events are rendered once per frame of the screen
+    m_repaintScheduler = new RepaintScheduler(this);
+    connect(m_repaintScheduler, &RepaintScheduler::frameRequested,
+            this, &CaptureWidget::renderFrame);
     updateCursor();
     initShortcuts();
 
-    // init content
-    QPixmap fullScreenshot(ScreenGrabber().grabEntireDesktop());
-    m_screenshot = new Screenshot(fullScreenshot, this);
-    QSize size = fullScreenshot.size();
-    // we need to increase by 1 the size to reach to the end of the screen
-    setGeometry(0 ,0 , size.width()+1, size.height()+1);
-
     // create buttons
     m_buttonHandler = new ButtonHandler(this);
-    updateButtons();
     m_buttonHandler->hide();
     // init interface color
     m_colorPicker = new ColorPicker(this);
     m_colorPicker->hide();
 
     m_notifierBox = new NotifierBox(this);
-    auto geometry = QGuiApplication::primaryScreen()->geometry();
-    m_notifierBox->move(geometry.left() +20, geometry.left() +20);
     m_notifierBox->hide();
+    updateConfig();
 }
 
 CaptureWidget::~CaptureWidget() {
-    ConfigHandler().setdrawThickness(m_thickness);
+    delete m_renderStatistics;
+}
+
+// startCapture grabs the screens and shows them to select the area to
+// capture. The time from the call to the first painted frame is measured.
+void CaptureWidget::startCapture(const QString &forcedSavePath) {
+    m_captureTimer.start();
+    if (m_screenshot) {
+        resetCapture();
+    }
+    m_forcedSavePath = forcedSavePath;
+
+    TiledImage desktop = ScreenGrabber().grabDesktop();
+    m_grabTime = m_captureTimer.nsecsElapsed();
+    m_screenshot = new Screenshot(desktop, this);
+    if (RenderStatistics::isEnabled()) {
+        m_renderStatistics = new RenderStatistics();
+        m_screenshot->setRenderStatistics(m_renderStatistics);
+        m_repaintScheduler->setRenderStatistics(m_renderStatistics);
+    }
+    QSize size = desktop.size();
+    // we need to increase by 1 the size to reach to the end of the screen
+    setGeometry(0 ,0 , size.width()+1, size.height()+1);
+
+    // the screens could have changed since the previous capture
+    m_helpMessage = QPixmap();
+    m_handle = QPixmap();
+    auto geometry = QGuiApplication::primaryScreen()->geometry();
+    m_notifierBox->move(geometry.left() +20, geometry.left() +20);
+
+    m_firstFramePainted = false;
+    showFullScreen();
+}
+
+// updateConfig reads the configuration used by the capture, the widget
+// can't be updated during a capture. The config file is written at the end
+// of every capture, so the buttons are only created again when their
+// configuration changed.
+void CaptureWidget::updateConfig() {
+    ConfigHandler config;
+    m_showHelp = config.showHelpValue();
+    m_showInitialMsg = m_showHelp;
+    m_thickness = config.drawThicknessValue();
+    QList<CaptureButton::ButtonType> buttons = config.getButtons();
+    if (buttons != m_configuredButtons
+            || config.uiMainColorValue() != m_uiColor
+            || config.uiContrastColorValue() != m_contrastUiColor)
+    {
+        m_configuredButtons = buttons;
+        m_colorPicker->setUIColor(config.uiMainColorValue());
+        updateButtons();
+    }
+}
+
+// closeEvent ends the capture, the widget is hidden and kept for the next
+// one
+void CaptureWidget::closeEvent(QCloseEvent *e) {
+    ConfigHandler config;
+    config.setdrawThickness(m_thickness);
+    config.setDrawColor(m_colorPicker->drawColor());
+    resetCapture();
+    QWidget::closeEvent(e);
+}
+
+// resetCapture releases the screenshot and restores the initial state of
+// the widget
+void CaptureWidget::resetCapture() {
+    if (m_renderStatistics) {
+        m_renderStatistics->saveSummary();
+        m_repaintScheduler->setRenderStatistics(nullptr);
+        delete m_renderStatistics;
+        m_renderStatistics = nullptr;
+    }
+    delete m_screenshot;
+    m_screenshot = nullptr;
+    m_modifications.clear();
+    m_redoModifications.clear();
+    m_selection = QRect();
+    m_mouseOverHandle = nullptr;
+    m_mouseIsClicked = false;
+    m_rightClick = false;
+    m_newSelection = false;
+    m_grabbing = false;
+    m_temporalModificationPending = false;
+    m_showInitialMsg = m_showHelp;
+    m_firstFramePainted = true;
+
+    m_state = CaptureButton::TYPE_MOVESELECTION;
+    if (m_lastPressedButton) {
+        m_lastPressedButton->setColor(m_uiColor);
+        m_lastPressedButton = nullptr;
+    }
+    m_buttonHandler->hide();
+    m_colorPicker->hide();
+    m_notifierBox->hide();
+    m_repaintScheduler->resetStatistics();
+    updateCursor();
 }
 
 // redefineButtons retrieves the buttons configured to be shown with the
@@ -112,11 +205,13 @@ void CaptureWidget::updateButtons() {
     ConfigHandler config;
     m_uiColor = config.uiMainColorValue();
     m_contrastUiColor = config.uiContrastColorValue();
+    // the cached layers use the interface color
+    m_helpMessage = QPixmap();
+    m_handle = QPixmap();
 
-    auto buttons = config.getButtons();
     QVector<CaptureButton*> vectorButtons;
 
-    for (const CaptureButton::ButtonType &t: buttons) {
+    for (const CaptureButton::ButtonType &t: m_configuredButtons) {
         CaptureButton *b = new CaptureButton(t, this);
         if (t == CaptureButton::TYPE_SELECTIONINDICATOR) {
             m_sizeIndButton = b;
@@ -135,61 +230,64 @@ QPixmap CaptureWidget::pixmap() {
     if (m_selection.isNull()) { // copy full screen when no selection
         return m_screenshot->screenshot();
     } else {
-        return m_screenshot->screenshot().copy(extendedSelection());
+        return m_screenshot->croppedScreenshot(extendedSelection());
     }
 }
 
-void CaptureWidget::paintEvent(QPaintEvent *) {
-    QPainter painter(this);
-
-    // if we are creating a new modification to the screenshot we just draw
-    // a temporal modification without antialiasing in the pencil tool for
-    // performance. When we are not drawing we just shot the modified screenshot
-    if (m_mouseIsClicked && m_state != CaptureButton::TYPE_MOVESELECTION) {
-        painter.drawPixmap(0, 0, m_screenshot->paintTemporalModification(
-                               m_modifications.last()));
-    } else {
-        painter.drawPixmap(0, 0, m_screenshot->screenshot());
+void CaptureWidget::paintEvent(QPaintEvent *e) {
+    if (!m_screenshot) {
+        return;
     }
+    QElapsedTimer paintTimer;
+    paintTimer.start();
+    m_repaintScheduler->beginPaint();
+    QPainter painter(this);
+    // only the damaged area is repainted, see updateSelection and the
+    // damage reported by the tools
+    const QRect damagedRect = e->rect();
 
-    QColor overlayColor(0, 0, 0, 190);
-    painter.setBrush(overlayColor);
+    // the screenshot is drawn bright inside of the selection and darkened
+    // outside of it, Screenshot keeps both versions precomputed
     QRect r = m_selection.normalized().adjusted(0, 0, -1, -1);
-    QRegion grey(rect());
+    QRegion grey(damagedRect);
     grey = grey.subtracted(r);
+    QRegion bright = QRegion(damagedRect).subtracted(grey);
+
+    // if we are creating a new modification to the screenshot we just draw
+    // the temporal modification layer over the modified screenshot, it is
+    // rendered as the points are added. The modification is added to the
+    // screenshot in mouseReleaseEvent
+    bool drawing = m_mouseIsClicked
+            && m_state != CaptureButton::TYPE_MOVESELECTION;
+    QRegion darkenedLayer;
+    if (drawing) {
+        // the layer has to be darkened after drawing it outside of the
+        // selection, the bright screenshot is used under it
+        darkenedLayer = grey.intersected(
+                    m_screenshot->temporalModificationRect());
+        grey = grey.subtracted(darkenedLayer);
+        bright += darkenedLayer;
+    }
 
     painter.setClipRegion(grey);
-    painter.drawRect(-1, -1, rect().width() + 1, rect().height() + 1);
+    m_screenshot->drawDarkScreenshot(painter, damagedRect);
+    painter.setClipRegion(bright);
+    m_screenshot->drawScreenshot(painter, damagedRect);
     painter.setClipRect(rect());
 
-    if (m_showInitialMsg) {
-        QRect helpRect = QGuiApplication::primaryScreen()->geometry();
-
-        QString helpTxt = tr("Select an area with the mouse, or press Esc to exit."
-                             "\nPress Enter to capture the screen."
-                             "\nPress Right Click to show the color picker."
-                             "\nUse the Mouse Wheel to change the thickness of your tool.");
-
-        // We draw the white contrasting background for the text, using the
-        //same text and options to get the boundingRect that the text will have.
-        QRectF bRect = painter.boundingRect(helpRect, Qt::AlignCenter, helpTxt);
-
-        // These four calls provide padding for the rect
-        bRect.setWidth(bRect.width() + 12);
-        bRect.setHeight(bRect.height() + 10);
-        bRect.setX(bRect.x() - 12);
-        bRect.setY(bRect.y() - 10);
-
-        QColor rectColor(m_uiColor);
-        rectColor.setAlpha(180);
-        painter.setBrush(QBrush(rectColor, Qt::SolidPattern));
-        painter.drawRect(bRect);
+    if (drawing) {
+        m_screenshot->drawTemporalModification(painter, damagedRect);
+        painter.setClipRegion(darkenedLayer);
+        painter.fillRect(darkenedLayer.boundingRect(),
+                         Screenshot::overlayColor());
+        painter.setClipRect(rect());
+    }
 
-        // Draw the text:
-        QColor textColor((CaptureButton::iconIsWhiteByColor(rectColor) ?
-                              Qt::white : Qt::black));
-        painter.setPen(QPen(textColor));
-        painter.drawText(helpRect, Qt::AlignCenter, helpTxt);
+    if (m_showInitialMsg) {
+        if (m_helpMessage.isNull()) {
+            initHelpMessage();
+        }
+        painter.drawPixmap(m_helpMessageRect.topLeft(), m_helpMessage);
     }
 
     if (!m_selection.isNull()) {
@@ -199,39 +297,156 @@ void CaptureWidget::paintEvent(QPaintEvent *) {
         painter.drawRect(r);
 
         // paint handlers
-        painter.setRenderHint(QPainter::Antialiasing);
         updateHandles();
-        painter.setBrush(m_uiColor);
-        for(auto r: handleMask().rects()) {
-            painter.drawRoundRect(r, 100, 100);
+        if (m_handle.isNull()) {
+            initHandle();
+        }
+        for (const QRect *const handle: m_Handles) {
+            painter.drawPixmap(handle->topLeft() - QPoint(1, 1), m_handle);
+        }
+    }
+
+    if (!m_firstFramePainted) {
+        m_firstFramePainted = true;
+        m_firstFrameLatency = m_captureTimer.nsecsElapsed();
+        if (m_renderStatistics) {
+            m_renderStatistics->setCaptureLatency(m_grabTime,
+                                                  m_firstFrameLatency);
         }
     }
+    if (m_renderStatistics) {
+        drawRenderStatistics(painter);
+        qint64 pixels = 0;
+        const QRegion region = e->region();
+#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+        for (const QRect &r: region) {
+#else
+        for (const QRect &r: region.rects()) {
+#endif
+            pixels += static_cast<qint64>(r.width()) * r.height();
+        }
+        m_renderStatistics->addFrame(paintTimer.nsecsElapsed(), pixels);
+    }
+    m_repaintScheduler->endPaint();
+}
+
+// drawRenderStatistics draws the statistics of the rendering and the frame
+// pacing at the top right corner of the main screen
+void CaptureWidget::drawRenderStatistics(QPainter &painter) {
+    RepaintScheduler::Statistics frames = m_repaintScheduler->statistics();
+    QStringList lines;
+    if (frames.frames > 0) {
+        lines << QStringLiteral("frames: %1 (%2 requests/frame)")
+                 .arg(frames.frames)
+                 .arg(frames.requests / qreal(frames.frames), 0, 'f', 1);
+    }
+    lines << m_renderStatistics->hudLines();
+
+    QRect screen = QGuiApplication::primaryScreen()->geometry();
+    int lineHeight = fontMetrics().height();
+    m_renderStatisticsRect = QRect(screen.right() - STATISTICS_WIDTH - 20,
+                                   screen.top() + 20, STATISTICS_WIDTH,
+                                   lines.size() * lineHeight + 10);
+    QColor background(Qt::black);
+    background.setAlpha(180);
+    painter.fillRect(m_renderStatisticsRect, background);
+    painter.setPen(Qt::white);
+    painter.drawText(m_renderStatisticsRect.adjusted(6, 5, -6, -5),
+                     Qt::AlignLeft | Qt::AlignTop, lines.join('\n'));
+}
+
+// initHelpMessage renders the help message shown at the beginning of the
+// capture, it is drawn from the cache in every paintEvent
+void CaptureWidget::initHelpMessage() {
+    QRect helpRect = QGuiApplication::primaryScreen()->geometry();
+
+    QString helpTxt = tr("Select an area with the mouse, or press Esc to exit."
+                         "\nPress Enter to capture the screen."
+                         "\nPress Right Click to show the color picker."
+                         "\nUse the Mouse Wheel to change the thickness of your tool.");
+
+    // We draw the white contrasting background for the text, using the
+    //same text and options to get the boundingRect that the text will have.
+    QRect bRect = fontMetrics().boundingRect(helpRect, Qt::AlignCenter, helpTxt);
+
+    // These four calls provide padding for the rect
+    bRect.setWidth(bRect.width() + 12);
+    bRect.setHeight(bRect.height() + 10);
+    bRect.setX(bRect.x() - 12);
+    bRect.setY(bRect.y() - 10);
+    // space for the border of the rect
+    m_helpMessageRect = bRect.adjusted(0, 0, 1, 1);
+
+    qreal devicePixelRatio = m_screenshot->devicePixelRatio();
+    m_helpMessage = QPixmap(m_helpMessageRect.size() * devicePixelRatio);
+    m_helpMessage.setDevicePixelRatio(devicePixelRatio);
+    m_helpMessage.fill(Qt::transparent);
+
+    QPainter painter(&m_helpMessage);
+    painter.setFont(font());
+    painter.translate(-m_helpMessageRect.topLeft());
+    QColor rectColor(m_uiColor);
+    rectColor.setAlpha(180);
+    painter.setBrush(QBrush(rectColor, Qt::SolidPattern));
+    painter.drawRect(bRect);
+
+    // Draw the text:
+    QColor textColor((CaptureButton::iconIsWhiteByColor(rectColor) ?
+                          Qt::white : Qt::black));
+    painter.setPen(QPen(textColor));
+    painter.drawText(helpRect, Qt::AlignCenter, helpTxt);
+}
+
+// initHandle renders the shape drawn for every handle of the selection,
+// with a pixel of margin for the antialiased border
+void CaptureWidget::initHandle() {
+    qreal devicePixelRatio = m_screenshot->devicePixelRatio();
+    m_handle = QPixmap(QSize(HANDLE_SIZE + 2, HANDLE_SIZE + 2) * devicePixelRatio);
+    m_handle.setDevicePixelRatio(devicePixelRatio);
+    m_handle.fill(Qt::transparent);
+
+    QPainter painter(&m_handle);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(m_uiColor);
+    painter.setBrush(m_uiColor);
+    painter.drawRoundRect(QRect(1, 1, HANDLE_SIZE, HANDLE_SIZE), 100, 100);
 }
 
 void CaptureWidget::mousePressEvent(QMouseEvent *e) {
+    if (m_renderStatistics) {
+        m_renderStatistics->inputReceived();
+    }
     if (e->button() == Qt::RightButton) {
         m_rightClick = true;
         m_colorPicker->move(e->pos().x()-m_colorPicker->width()/2,
                             e->pos().y()-m_colorPicker->height()/2);
         m_colorPicker->show();
     } else if (e->button() == Qt::LeftButton) {
-        m_showInitialMsg = false;
+        if (m_showInitialMsg) {
+            // the help message covers the center of the screen
+            m_showInitialMsg = false;
+            update();
+        }
         m_mouseIsClicked = true;
         if (m_state != CaptureButton::TYPE_MOVESELECTION) {
-            auto mod = new CaptureModification(m_state, e->pos(),
-                                               m_colorPicker->drawColor(),
-                                               m_thickness,
-                                               this);
-            m_modifications.append(mod);
+            m_modifications.append(CaptureModification(
+                                       m_state, e->pos(),
+                                       m_colorPicker->drawColor(),
+                                       m_thickness));
+            // the undone modifications can't be redone after drawing
+            m_redoModifications.clear();
+            m_temporalModificationPending = true;
+            m_repaintScheduler->scheduleFrame();
             return;
         }
         m_dragStartPoint = e->pos();
         m_selectionBeforeDrag = m_selection;
         if (!m_selection.contains(e->pos()) && !m_mouseOverHandle) {
             m_newSelection = true;
+            QRect previousSelection = m_selection;
             m_selection = QRect();
             m_buttonHandler->hide();
-            update();
+            updateSelection(previousSelection);
         } else {
             m_grabbing = true;
         }
@@ -240,15 +455,19 @@ void CaptureWidget::mousePressEvent(QMouseEvent *e) {
 }
 
 void CaptureWidget::mouseMoveEvent(QMouseEvent *e) {
+    if (m_renderStatistics) {
+        m_renderStatistics->inputReceived();
+    }
     m_mousePos = e->pos();
 
     if (m_mouseIsClicked && m_state == CaptureButton::TYPE_MOVESELECTION) {
         if (m_buttonHandler->isVisible()) {
             m_buttonHandler->hide();
         }
+        QRect previousSelection = m_selection;
         if (m_newSelection) {
             m_selection = QRect(m_dragStartPoint, m_mousePos).normalized();
-            update();
+            updateSelection(previousSelection);
         } else if (!m_mouseOverHandle) {
             // Moving the whole selection
             QRect r = rect().normalized();
@@ -267,7 +486,7 @@ void CaptureWidget::mouseMoveEvent(QMouseEvent *e) {
             } if (!r.contains(QPoint(r.center().x(), m_selection.bottom()))) {
                 m_selection.setBottom(r.bottom());
             }
-            update();
+            updateSelection(previousSelection);
         } else {
             // Dragging a handle
             QRect r = m_selectionBeforeDrag;
@@ -307,12 +526,14 @@ void CaptureWidget::mouseMoveEvent(QMouseEvent *e) {
                 }
             }
             m_selection = r.normalized();
-            update();
+            updateSelection(previousSelection);
         }
     } else if (m_mouseIsClicked && m_state != CaptureButton::TYPE_MOVESELECTION) {
-        // drawing with a tool
-        m_modifications.last()->addPoint(e->pos());
-        update();
+        // drawing with a tool, every point is stored but the temporal
+        // layer is rendered once per frame in renderFrame
+        m_modifications.last().addPoint(e->pos());
+        m_temporalModificationPending = true;
+        m_repaintScheduler->scheduleFrame();
         // hides the group of buttons under the mouse, if you leave
         if (m_buttonHandler->buttonsAreInside()) {
             bool containsMouse = m_buttonHandler->contains(m_mousePos);
@@ -342,14 +563,22 @@ void CaptureWidget::mouseMoveEvent(QMouseEvent *e) {
 }
 
 void CaptureWidget::mouseReleaseEvent(QMouseEvent *e) {
+    if (m_renderStatistics) {
+        m_renderStatistics->inputReceived();
+    }
     if (e->button() == Qt::RightButton) {
         m_colorPicker->hide();
         m_rightClick = false;
     // when we end the drawing of a modification in the capture we have to
     // register the last point and add the whole modification to the screenshot
     } else if (m_mouseIsClicked && m_state != CaptureButton::TYPE_MOVESELECTION) {
-        m_screenshot->paintModification(m_modifications.last());
-        update();
+        const CaptureModification &modification = m_modifications.last();
+        QRect damage = m_screenshot->temporalModificationRect();
+        m_screenshot->paintModification(modification);
+        m_screenshot->clearTemporalModification();
+        m_temporalModificationPending = false;
+        m_repaintScheduler->scheduleUpdate(
+                    damage.united(modification.boundingRect()));
     }
 
     if (!m_buttonHandler->isVisible() && !m_selection.isNull()) {
@@ -369,24 +598,28 @@ void CaptureWidget::keyPressEvent(QKeyEvent *e) {
         return;
     } else if (e->key() == Qt::Key_Up
                && m_selection.top() > rect().top()) {
+        QRect previousSelection = m_selection;
         m_selection.moveTop(m_selection.top()-1);
         m_buttonHandler->updatePosition(m_selection, rect());
-        update();
+        updateSelection(previousSelection);
     } else if (e->key() == Qt::Key_Down
                && m_selection.bottom() < rect().bottom()) {
+        QRect previousSelection = m_selection;
         m_selection.moveBottom(m_selection.bottom()+1);
         m_buttonHandler->updatePosition(m_selection, rect());
-        update();
+        updateSelection(previousSelection);
     } else if (e->key() == Qt::Key_Left
                && m_selection.left() > rect().left()) {
+        QRect previousSelection = m_selection;
         m_selection.moveLeft(m_selection.left()-1);
         m_buttonHandler->updatePosition(m_selection, rect());
-        update();
+        updateSelection(previousSelection);
     } else if (e->key() == Qt::Key_Right
                && m_selection.right() < rect().right()) {
+        QRect previousSelection = m_selection;
         m_selection.moveRight(m_selection.right()+1);
         m_buttonHandler->updatePosition(m_selection, rect());
-        update();
+        updateSelection(previousSelection);
     }
 }
 
@@ -399,15 +632,28 @@ void CaptureWidget::wheelEvent(QWheelEvent *e) {
 bool CaptureWidget::undo() {
     bool itemRemoved = false;
     if (!m_modifications.isEmpty()) {
-        m_modifications.last()->deleteLater();
-        m_modifications.pop_back();
-        m_screenshot->overrideModifications(m_modifications);
-        update();
+        CaptureModification modification = m_modifications.takeLast();
+        m_redoModifications.append(modification);
+        m_screenshot->undoModification(m_modifications);
+        m_repaintScheduler->scheduleUpdate(modification.boundingRect());
         itemRemoved = true;
     }
     return itemRemoved;
 }
 
+bool CaptureWidget::redo() {
+    bool itemAdded = false;
+    if (!m_redoModifications.isEmpty()) {
+        CaptureModification modification = m_redoModifications.takeLast();
+        m_modifications.append(modification);
+        m_screenshot->paintModification(modification);
+        m_repaintScheduler->scheduleUpdate(modification.boundingRect());
+        itemAdded = true;
+    }
+    return itemAdded;
+}
+
+
 void CaptureWidget::setState(CaptureButton *b) {
     CaptureButton::ButtonType t = b->buttonType();
     if (b->tool()->isSelectable()) {
@@ -467,39 +713,58 @@ void CaptureWidget::handleButtonSignal(CaptureTool::Request r) {
     }
 }
 
+// renderFrame renders the points added to the modification being drawn
+// since the previous frame, the damage is repainted in the same frame. The
+// rendering statistics are repainted in every frame.
+void CaptureWidget::renderFrame() {
+    if (m_temporalModificationPending && !m_modifications.isEmpty()) {
+        m_temporalModificationPending = false;
+        m_repaintScheduler->scheduleUpdate(
+                    m_screenshot->paintTemporalModification(
+                        m_modifications.last()));
+    }
+    if (m_renderStatistics) {
+        m_repaintScheduler->scheduleUpdate(m_renderStatisticsRect);
+    }
+}
+
 void CaptureWidget::leftResize() {
     if (!m_selection.isNull() && m_selection.right() > m_selection.left()) {
+        QRect previousSelection = m_selection;
         m_selection.setRight(m_selection.right()-1);
         m_buttonHandler->updatePosition(m_selection, rect());
         updateSizeIndicator();
-        update();
+        updateSelection(previousSelection);
     }
 }
 
 void CaptureWidget::rightResize() {
     if (!m_selection.isNull() && m_selection.right() < rect().right()) {
+        QRect previousSelection = m_selection;
         m_selection.setRight(m_selection.right()+1);
         m_buttonHandler->updatePosition(m_selection, rect());
         updateSizeIndicator();
-        update();
+        updateSelection(previousSelection);
     }
 }
 
 void CaptureWidget::upResize() {
     if (!m_selection.isNull() && m_selection.bottom() > m_selection.top()) {
+        QRect previousSelection = m_selection;
         m_selection.setBottom(m_selection.bottom()-1);
         m_buttonHandler->updatePosition(m_selection, rect());
         updateSizeIndicator();
-        update();
+        updateSelection(previousSelection);
     }
 }
 
 void CaptureWidget::downResize() {
     if (!m_selection.isNull() && m_selection.bottom() < rect().bottom()) {
+        QRect previousSelection = m_selection;
         m_selection.setBottom(m_selection.bottom()+1);
         m_buttonHandler->updatePosition(m_selection, rect());
         updateSizeIndicator();
-        update();
+        updateSelection(previousSelection);
     }
 }
 
@@ -508,6 +773,7 @@ void CaptureWidget::initShortcuts() {
     new QShortcut(QKeySequence(Qt::CTRL + Qt::Key_S), this, SLOT(saveScreenshot()));
     new QShortcut(QKeySequence(Qt::CTRL + Qt::Key_C), this, SLOT(copyScreenshot()));
     new QShortcut(QKeySequence(Qt::CTRL + Qt::Key_Z), this, SLOT(undo()));
+    new QShortcut(QKeySequence(Qt::CTRL + Qt::SHIFT + Qt::Key_Z), this, SLOT(redo()));
     new QShortcut(QKeySequence(Qt::SHIFT + Qt::Key_Right), this, SLOT(rightResize()));
     new QShortcut(QKeySequence(Qt::SHIFT + Qt::Key_Left), this, SLOT(leftResize()));
     new QShortcut(QKeySequence(Qt::SHIFT + Qt::Key_Up), this, SLOT(upResize()));
@@ -531,6 +797,22 @@ void CaptureWidget::updateHandles() {
     m_BHandle.moveBottomLeft(QPoint(r.x() + r.width() / 2 - s2, r.bottom() + s2));
 }
 
+// updateSelection schedules the repaint of the area affected by a change of
+// the selection: the previous and the new selection with their handles.
+void CaptureWidget::updateSelection(const QRect &previousSelection) {
+    QRegion damage(selectionDamageRect(previousSelection));
+    damage += selectionDamageRect(m_selection);
+    m_repaintScheduler->scheduleUpdate(damage);
+}
+
+QRect CaptureWidget::selectionDamageRect(const QRect &selection) const {
+    if (selection.isNull()) {
+        return QRect();
+    }
+    return selection.normalized().adjusted(-HANDLE_SIZE, -HANDLE_SIZE,
+                                           HANDLE_SIZE, HANDLE_SIZE);
+}
+
 void CaptureWidget::updateSizeIndicator() {
     // The grabbed region is everything which is covered by the drawn
     // rectangles (border included, that's the reason of the +2).
@@ -576,29 +858,50 @@ QRegion CaptureWidget::handleMask() const {
     return mask;
 }
 
+// stageTimings returns the milliseconds spent grabbing the screens, until
+// the first frame and until the capture was accepted
+QVariantMap CaptureWidget::stageTimings() const {
+    QVariantMap timings;
+    timings.insert("grab", m_grabTime / 1000000.0);
+    timings.insert("firstFrame", m_firstFrameLatency / 1000000.0);
+    timings.insert("selection", m_captureTimer.nsecsElapsed() / 1000000.0);
+    return timings;
+}
+
 void CaptureWidget::copyScreenshot() {
     ResourceExporter().captureToClipboard(pixmap());
+    emit captureCompleted("clipboard", stageTimings());
     close();
 }
 
+// saveScreenshot opens the save dialog or saves in the forced path, the
+// completion is signaled when the file is written, with its path
 void CaptureWidget::saveScreenshot() {
     if (m_forcedSavePath.isEmpty()) {
         ResourceExporter().captureToFileUi(pixmap());
+        emit captureCompleted("dialog", stageTimings());
     } else {
-        ResourceExporter().captureToFile(pixmap(), m_forcedSavePath);
+        QVariantMap timings = stageTimings();
+        auto onSaved = [this, timings](const QString &path, qint64 elapsed) {
+            QVariantMap t = timings;
+            t.insert("save", static_cast<double>(elapsed));
+            emit captureCompleted(path, t);
+        };
+        ResourceExporter().captureToFile(pixmap(), m_forcedSavePath, onSaved);
     }
     close();
 }
 
 void CaptureWidget::uploadToImgur() {
     ResourceExporter().captureToImgur(pixmap());
+    emit captureCompleted("imgur", stageTimings());
     close();
 }
 
 QRect CaptureWidget::extendedSelection() const {
     if (m_selection.isNull())
         return QRect();
-    auto devicePixelRatio = m_screenshot->screenshot().devicePixelRatio();
+    auto devicePixelRatio = m_screenshot->devicePixelRatio();
 
     return QRect(m_selection.left()   * devicePixelRatio,
                  m_selection.top()    * devicePixelRatio,
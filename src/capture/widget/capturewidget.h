@@ -27,35 +27,44 @@
 #include "capturebutton.h"
 #include "src/capture/tools/capturetool.h"
 #include "buttonhandler.h"
+#include "src/capture/capturemodification.h"
 #include <QWidget>
 #include <QPointer>
+#include <QElapsedTimer>
+#include <QVariantMap>
 
 class QPaintEvent;
 class QResizeEvent;
 class QMouseEvent;
-class CaptureModification;
 class QNetworkAccessManager;
 class QNetworkReply;
 class ColorPicker;
 class Screenshot;
 class NotifierBox;
+class RepaintScheduler;
+class RenderStatistics;
 
 class CaptureWidget : public QWidget {
     Q_OBJECT
 
 public:
-    explicit CaptureWidget(const QString &forcedSavePath = QString(),
-                           QWidget *parent = nullptr);
+    explicit CaptureWidget(QWidget *parent = nullptr);
     ~CaptureWidget();
 
+    void startCapture(const QString &forcedSavePath = QString());
+    void updateConfig();
     void updateButtons();
     QPixmap pixmap();
 
+signals:
+    void captureCompleted(const QString &location, const QVariantMap &timings);
+
 private slots:
     void copyScreenshot();
     void saveScreenshot();
     void uploadToImgur();
     bool undo();
+    bool redo();
 
     void leftResize();
     void rightResize();
@@ -65,8 +74,11 @@ private slots:
     void setState(CaptureButton *);
     void handleButtonSignal(CaptureTool::Request r);
 
+    void renderFrame();
+
 protected:
     void paintEvent(QPaintEvent *);
+    void closeEvent(QCloseEvent *);
     void mousePressEvent(QMouseEvent *);
     void mouseMoveEvent(QMouseEvent *);
     void mouseReleaseEvent(QMouseEvent *);
@@ -90,11 +102,23 @@ protected:
     bool m_newSelection;
     bool m_grabbing;
     bool m_showInitialMsg;
+    bool m_showHelp;
+    // points were added to the modification being drawn since the last frame
+    bool m_temporalModificationPending;
 
-    const QString m_forcedSavePath;
+    QString m_forcedSavePath;
 
     int m_thickness;
     NotifierBox *m_notifierBox;
+    RepaintScheduler *m_repaintScheduler;
+    // null unless the rendering statistics are enabled
+    RenderStatistics *m_renderStatistics;
+
+    // latency of the capture, from startCapture to the first frame
+    bool m_firstFramePainted;
+    QElapsedTimer m_captureTimer;
+    qint64 m_grabTime;
+    qint64 m_firstFrameLatency;
 
     // naming convention for handles
     // T top, B bottom, R Right, L left
@@ -106,23 +130,40 @@ protected:
     QVector<QRect*> m_Handles;
 
 private:
+    QVariantMap stageTimings() const;
     void initShortcuts();
+    void resetCapture();
     void updateHandles();
+    void updateSelection(const QRect &previousSelection);
+    QRect selectionDamageRect(const QRect &selection) const;
     void updateSizeIndicator();
     void updateCursor();
+    void initHelpMessage();
+    void initHandle();
+    void drawRenderStatistics(QPainter &);
 
     QRect extendedSelection() const;
-    QVector<CaptureModification*> m_modifications;
+    QVector<CaptureModification> m_modifications;
+    // undone modifications, the last one is the next to redo
+    QVector<CaptureModification> m_redoModifications;
     QPointer<CaptureButton> m_sizeIndButton;
     QPointer<CaptureButton> m_lastPressedButton;
 
     CaptureButton::ButtonType m_state;
     ButtonHandler *m_buttonHandler;
+    // buttons of the config used to create the current ones
+    QList<CaptureButton::ButtonType> m_configuredButtons;
 
     QColor m_uiColor;
     QColor m_contrastUiColor;
     ColorPicker *m_colorPicker;
 
+    // cached static layers of the interface
+    QPixmap m_helpMessage;
+    QRect m_helpMessageRect;
+    QPixmap m_handle;
+    QRect m_renderStatisticsRect;
+
 };
 
 #endif // CAPTUREWIDGET_H
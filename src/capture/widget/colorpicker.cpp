@@ -58,6 +58,10 @@ QColor ColorPicker::drawColor() {
     return m_drawColor;
 }
 
+void ColorPicker::setUIColor(const QColor &color) {
+    m_uiColor = color;
+}
+
 void ColorPicker::show() {
     grabMouse();
     QWidget::show();
@@ -28,6 +28,7 @@ public:
     ~ColorPicker();
 
     QColor drawColor();
+    void setUIColor(const QColor &);
 
     void show();
     void hide();
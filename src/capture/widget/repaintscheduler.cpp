@@ -0,0 +1,134 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "repaintscheduler.h"
+#include "src/capture/renderstatistics.h"
+#include <QGuiApplication>
+#include <QScreen>
+#include <QWidget>
+#include <QTimer>
+
+// RepaintScheduler merges the update requests of a widget and repaints it at
+// most once per frame of the screen. The input events only store their work,
+// it is rendered when frameRequested is emitted.
+
+namespace {
+
+const qreal DEFAULT_FRAME_RATE = 60;
+const qreal MAX_FRAME_RATE = 240;
+
+} // unnamed namespace
+
+RepaintScheduler::RepaintScheduler(QWidget *widget) : QObject(widget),
+    m_widget(widget), m_flushing(false), m_pendingRequests(0),
+    m_continuous(false), m_renderStatistics(nullptr)
+{
+    m_frameRate = DEFAULT_FRAME_RATE;
+    QScreen *screen = QGuiApplication::primaryScreen();
+    if (screen && screen->refreshRate() > 1) {
+        m_frameRate = qMin(screen->refreshRate(), MAX_FRAME_RATE);
+    }
+    m_frameInterval = qRound(1000 / m_frameRate);
+
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &RepaintScheduler::flush);
+    resetStatistics();
+}
+
+// scheduleUpdate adds the damage to the next frame
+void RepaintScheduler::scheduleUpdate(const QRegion &damage) {
+    m_damage += damage;
+    scheduleFrame();
+}
+
+// scheduleFrame starts the timer of the next frame, waiting the remaining
+// time of the frame interval since the last one
+void RepaintScheduler::scheduleFrame() {
+    // the damage added while flushing is part of the current frame
+    if (m_flushing) {
+        return;
+    }
+    ++m_pendingRequests;
+    if (m_timer->isActive()) {
+        return;
+    }
+    int wait = 0;
+    m_continuous = false;
+    if (m_lastFrame.isValid()) {
+        int elapsed = static_cast<int>(m_lastFrame.elapsed());
+        wait = qMax(0, m_frameInterval - elapsed);
+        // a frame requested after an idle period would measure the time
+        // between the input events instead of the rendering
+        m_continuous = elapsed < 2 * m_frameInterval;
+    }
+    m_timer->start(wait);
+}
+
+void RepaintScheduler::flush() {
+    m_flushing = true;
+    emit frameRequested();
+    m_flushing = false;
+
+    if (m_continuous && m_renderStatistics) {
+        m_renderStatistics->addFrameInterval(m_lastFrame.nsecsElapsed());
+    }
+    m_lastFrame.start();
+    ++m_statistics.frames;
+    m_statistics.requests += m_pendingRequests;
+    m_pendingRequests = 0;
+
+    if (!m_damage.isEmpty()) {
+        m_widget->update(m_damage);
+        m_damage = QRegion();
+    }
+}
+
+// beginPaint and endPaint measure the paint time, they are called at the
+// beginning and the end of the paintEvent of the widget
+void RepaintScheduler::beginPaint() {
+    m_paintTimer.start();
+}
+
+void RepaintScheduler::endPaint() {
+    qint64 paintTime = m_paintTimer.nsecsElapsed();
+    m_statistics.totalPaintTime += paintTime;
+    m_statistics.maxPaintTime = qMax(m_statistics.maxPaintTime, paintTime);
+}
+
+qreal RepaintScheduler::frameRate() const {
+    return m_frameRate;
+}
+
+RepaintScheduler::Statistics RepaintScheduler::statistics() const {
+    return m_statistics;
+}
+
+void RepaintScheduler::resetStatistics() {
+    m_statistics = Statistics();
+    m_statistics.frames = 0;
+    m_statistics.requests = 0;
+    m_statistics.totalPaintTime = 0;
+    m_statistics.maxPaintTime = 0;
+}
+
+// setRenderStatistics sets the statistics receiving the intervals between
+// the frames rendered back to back, nullptr stops measuring them
+void RepaintScheduler::setRenderStatistics(RenderStatistics *statistics) {
+    m_renderStatistics = statistics;
+}
@@ -0,0 +1,79 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef REPAINTSCHEDULER_H
+#define REPAINTSCHEDULER_H
+
+#include <QObject>
+#include <QRegion>
+#include <QElapsedTimer>
+
+class QWidget;
+class QTimer;
+class RenderStatistics;
+
+class RepaintScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    // times in nanoseconds
+    struct Statistics {
+        int frames;
+        // update requests merged in the frames
+        int requests;
+        qint64 totalPaintTime;
+        qint64 maxPaintTime;
+    };
+
+    explicit RepaintScheduler(QWidget *widget);
+
+    void scheduleUpdate(const QRegion &damage);
+    void scheduleFrame();
+
+    void beginPaint();
+    void endPaint();
+
+    qreal frameRate() const;
+    Statistics statistics() const;
+    void resetStatistics();
+    void setRenderStatistics(RenderStatistics *);
+
+signals:
+    // emitted before repainting a frame so the pending work can be rendered
+    void frameRequested();
+
+private slots:
+    void flush();
+
+private:
+    QWidget *m_widget;
+    QTimer *m_timer;
+    QRegion m_damage;
+    qreal m_frameRate;
+    int m_frameInterval;
+    bool m_flushing;
+    int m_pendingRequests;
+    // the frame was requested before the end of the next frame interval
+    bool m_continuous;
+
+    QElapsedTimer m_lastFrame;
+    QElapsedTimer m_paintTimer;
+    Statistics m_statistics;
+    RenderStatistics *m_renderStatistics;
+};
+
+#endif // REPAINTSCHEDULER_H
@@ -0,0 +1,50 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "archivetask.h"
+#include "src/capture/workers/savetask.h"
+#include "src/capture/workers/tilearchive.h"
+#include <QThreadPool>
+
+// ArchiveTask appends a capture to a tile archive in the worker threads of
+// SaveTask, the tiles are hashed and compressed there and the wait for the
+// lock of the archive doesn't block the GUI. The task deletes itself once
+// finished.
+
+ArchiveTask::ArchiveTask(const QImage &image, const QString &archivePath,
+                         const int keyframeInterval, QObject *parent) :
+    QObject(parent), m_image(image), m_archivePath(archivePath),
+    m_keyframeInterval(keyframeInterval)
+{
+    m_timer.start();
+    setAutoDelete(false);
+}
+
+void ArchiveTask::start() {
+    // connected last, after the receivers of the result
+    connect(this, &ArchiveTask::finished, this, &ArchiveTask::deleteLater,
+            Qt::QueuedConnection);
+    SaveTask::pool()->start(this);
+}
+
+void ArchiveTask::run() {
+    TileArchive archive(m_archivePath);
+    int tiles = archive.append(m_image, m_keyframeInterval);
+    m_image = QImage();
+    emit finished(tiles, m_archivePath, archive.errorString(),
+                  m_timer.elapsed());
+}
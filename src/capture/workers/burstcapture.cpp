@@ -0,0 +1,214 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "burstcapture.h"
+#include "src/capture/tiledimage.h"
+#include "src/utils/screengrabber.h"
+#include "src/utils/filenamehandler.h"
+#include "src/utils/systemnotification.h"
+#include <QThreadPool>
+#include <QRunnable>
+#include <QTimer>
+#include <QFile>
+#include <QFileInfo>
+
+// BurstCapture takes a number of screenshots at a fixed interval. The
+// frames are grabbed in the GUI thread and saved by a pool of encoder
+// threads, the grab never waits for the encoders: when every buffer is
+// being encoded the frame is dropped. The frames are also dropped when
+// the previous grabs took longer than the interval, the late ones are
+// counted.
+
+namespace {
+
+// frames which can wait to be encoded besides the ones being encoded
+const int QUEUE_SIZE = 2;
+
+class FrameEncoder : public QRunnable {
+public:
+    FrameEncoder(QObject *receiver, const QImage &frame, const int buffer,
+                 const QString &path, const ImageEncoder &encoder) :
+        m_receiver(receiver), m_frame(frame), m_buffer(buffer), m_path(path),
+        m_encoder(encoder)
+    {
+    }
+
+    void run() {
+        bool saved = m_encoder.write(m_frame, m_path);
+        if (!saved) {
+            QFile::remove(m_path);
+        }
+        // the buffer can't be shared when it's reused
+        m_frame = QImage();
+        QMetaObject::invokeMethod(m_receiver, "releaseFrame",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(int, m_buffer), Q_ARG(bool, saved));
+    }
+
+private:
+    QObject *m_receiver;
+    QImage m_frame;
+    int m_buffer;
+    QString m_path;
+    ImageEncoder m_encoder;
+};
+
+} // unnamed namespace
+
+BurstCapture::BurstCapture(const QString &path, const int interval,
+                           const int count, const int screen,
+                           const QRect &area, QObject *parent) :
+    QObject(parent), m_interval(qMax(interval, 1)), m_count(count),
+    m_screen(screen), m_area(area), m_nextFrame(0), m_saved(0), m_failed(0),
+    m_dropped(0), m_late(0), m_grabbing(false)
+{
+    // the size is only known when the area is set
+    FileNameHandler nameHandler;
+    nameHandler.setCaptureInfo(area.size(), screen);
+    // the frames aren't indexed under the base name, a base name whose
+    // first frame exists was used by a previous burst
+    do {
+        QString directory = path;
+        QString filename;
+        QFileInfo base;
+        if (directory.isEmpty()) {
+            base.setFile(nameHandler.absoluteSavePath(directory, filename,
+                                                      m_encoder.format(),
+                                                      FileNameIndex::RESERVE));
+        } else {
+            base.setFile(nameHandler.generateAbsolutePath(directory,
+                                                          m_encoder.format()));
+        }
+        m_directory = base.path() + "/";
+        m_baseName = base.fileName();
+    } while (QFileInfo::exists(m_directory + frameName(0) + "."
+                               + m_encoder.format()));
+
+    m_pool = new QThreadPool(this);
+    m_maxBuffers = m_pool->maxThreadCount() + QUEUE_SIZE;
+
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &BurstCapture::captureFrame);
+}
+
+void BurstCapture::start() {
+    m_grabbing = true;
+    m_clock.start();
+    captureFrame();
+}
+
+// captureFrame grabs the next frame and schedules the following one at its
+// time in the burst
+void BurstCapture::captureFrame() {
+    qint64 now = m_clock.elapsed();
+    qint64 due = static_cast<qint64>(m_nextFrame) * m_interval;
+    // the frames whose time passed while grabbing are dropped
+    while (m_nextFrame + 1 < m_count && now >= due + m_interval) {
+        ++m_dropped;
+        ++m_nextFrame;
+        due += m_interval;
+    }
+    if (now - due > m_interval / 4) {
+        ++m_late;
+    }
+
+    TiledImage capture = grab();
+    if (capture.isNull()) {
+        ++m_failed;
+    } else {
+        int buffer = -1;
+        if (!m_freeBuffers.isEmpty()) {
+            buffer = m_freeBuffers.takeLast();
+        } else if (m_buffers.size() < m_maxBuffers) {
+            buffer = m_buffers.size();
+            m_buffers.append(QImage());
+        }
+        if (buffer < 0) {
+            ++m_dropped;
+        } else {
+            QImage &frame = m_buffers[buffer];
+            if (frame.size() != capture.size()) {
+                frame = QImage(capture.size(), QImage::Format_RGB32);
+            }
+            capture.copyTo(frame);
+            m_pool->start(new FrameEncoder(this, frame, buffer,
+                                           createFrameFile(m_nextFrame),
+                                           m_encoder));
+        }
+    }
+
+    ++m_nextFrame;
+    if (m_nextFrame < m_count) {
+        qint64 wait = static_cast<qint64>(m_nextFrame) * m_interval
+                - m_clock.elapsed();
+        m_timer->start(static_cast<int>(qMax<qint64>(0, wait)));
+    } else {
+        m_grabbing = false;
+        finishIfDone();
+    }
+}
+
+void BurstCapture::releaseFrame(const int buffer, const bool saved) {
+    m_freeBuffers.append(buffer);
+    if (saved) {
+        ++m_saved;
+    } else {
+        ++m_failed;
+    }
+    finishIfDone();
+}
+
+TiledImage BurstCapture::grab() {
+    ScreenGrabber grabber;
+    if (m_screen >= 0) {
+        return grabber.grabScreen(m_screen, m_area);
+    } else if (m_area.isEmpty()) {
+        return grabber.grabDesktop();
+    }
+    return grabber.grabArea(m_area);
+}
+
+QString BurstCapture::frameName(const int frame) const {
+    int digits = QString::number(m_count - 1).size();
+    return QStringLiteral("%1_%2").arg(m_baseName)
+            .arg(frame, digits, 10, QLatin1Char('0'));
+}
+
+// createFrameFile creates the file of a frame exclusively and returns its
+// path, a number is added to the name when another process took it
+QString BurstCapture::createFrameFile(const int frame) {
+    QString name = FileNameIndex::getInstance()->availableName(
+                m_directory, frameName(frame), m_encoder.format(),
+                FileNameIndex::CREATE);
+    return m_directory + name + "." + m_encoder.format();
+}
+
+// finishIfDone reports the result of the burst when every frame has been
+// grabbed and encoded
+void BurstCapture::finishIfDone() {
+    if (m_grabbing || m_freeBuffers.size() != m_buffers.size()) {
+        return;
+    }
+    QString message = tr("Burst capture finished: %1 of %2 frames saved, "
+                         "%3 dropped, %4 late, %5 failed")
+            .arg(m_saved).arg(m_count).arg(m_dropped).arg(m_late)
+            .arg(m_failed);
+    SystemNotification().sendMessage(message);
+    deleteLater();
+}
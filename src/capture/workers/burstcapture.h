@@ -0,0 +1,77 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef BURSTCAPTURE_H
+#define BURSTCAPTURE_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QVector>
+#include <QRect>
+#include "src/utils/imageencoder.h"
+
+class QTimer;
+class QThreadPool;
+class TiledImage;
+
+class BurstCapture : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BurstCapture(const QString &path, const int interval,
+                          const int count, const int screen, const QRect &area,
+                          QObject *parent = nullptr);
+
+    void start();
+
+private slots:
+    void captureFrame();
+    void releaseFrame(const int buffer, const bool saved);
+
+private:
+    QString m_directory;
+    QString m_baseName;
+    int m_interval;
+    int m_count;
+    int m_screen;
+    QRect m_area;
+    ImageEncoder m_encoder;
+
+    QTimer *m_timer;
+    QElapsedTimer m_clock;
+    QThreadPool *m_pool;
+
+    // frames grabbed or being encoded, the free ones are reused
+    QVector<QImage> m_buffers;
+    QVector<int> m_freeBuffers;
+    int m_maxBuffers;
+
+    int m_nextFrame;
+    int m_saved;
+    int m_failed;
+    int m_dropped;
+    int m_late;
+    bool m_grabbing;
+
+    TiledImage grab();
+    QString frameName(const int frame) const;
+    QString createFrameFile(const int frame);
+    void finishIfDone();
+};
+
+#endif // BURSTCAPTURE_H
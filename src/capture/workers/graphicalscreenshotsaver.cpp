@@ -19,8 +19,12 @@
 #include "src/utils/confighandler.h"
 #include "src/utils/systemnotification.h"
 #include "src/utils/filenamehandler.h"
+#include "src/capture/workers/savetask.h"
+#include "src/capture/workers/screenshotsaver.h"
+#include "src/utils/imageencoder.h"
 #include <QFileDialog>
 #include <QImageWriter>
+#include <QMimeDatabase>
 #include <QMessageBox>
 #include <QShortcut>
 #include <QVBoxLayout>
@@ -32,7 +36,7 @@
 
 GraphicalScreenshotSaver::GraphicalScreenshotSaver(const QPixmap &capture,
                                                    QWidget *parent) :
-    QWidget(parent), m_pixmap(capture)
+    QWidget(parent), m_image(capture.toImage())
 {
     setAttribute(Qt::WA_DeleteOnClose);
     setWindowTitle(QObject::tr("Save As"));
@@ -50,8 +54,11 @@ void GraphicalScreenshotSaver::initFileDialog() {
     m_fileDialog->setOption(QFileDialog::DontUseNativeDialog, true);
     m_fileDialog->setFileMode(QFileDialog::AnyFile);
     m_fileDialog->setAcceptMode(QFileDialog::AcceptSave);
+    QString format = ImageEncoder().format();
     QString fileName, directory;
-    FileNameHandler().absoluteSavePath(directory, fileName);
+    FileNameHandler nameHandler;
+    nameHandler.setCaptureInfo(m_image.size());
+    nameHandler.absoluteSavePath(directory, fileName, format);
     m_fileDialog->selectFile(fileName);
     m_fileDialog->setDirectory(directory);
 
@@ -59,8 +66,12 @@ void GraphicalScreenshotSaver::initFileDialog() {
     for (const QByteArray &bf: QImageWriter::supportedMimeTypes())
         mimeTypes.append(QLatin1String(bf));
     m_fileDialog->setMimeTypeFilters(mimeTypes);
-    m_fileDialog->selectMimeTypeFilter("image/png");
-    m_fileDialog->setDefaultSuffix("png");
+    // the configured format, QOI has no filter and takes the default one
+    QString mimeType = QMimeDatabase().mimeTypeForFile(
+                "capture." + format, QMimeDatabase::MatchExtension).name();
+    m_fileDialog->selectMimeTypeFilter(mimeTypes.contains(mimeType) ?
+                                           mimeType : "image/png");
+    m_fileDialog->setDefaultSuffix(format);
 
     connect(m_fileDialog, &QFileDialog::rejected,
             this, &GraphicalScreenshotSaver::close);
@@ -77,17 +88,31 @@ void GraphicalScreenshotSaver::showErrorMessage(const QString &msg) {
     saveErrBox.exec();
 }
 
+// checkSaveAcepted starts the encoding in a worker thread, the window is
+// disabled until the capture is written
 void GraphicalScreenshotSaver::checkSaveAcepted() {
     m_fileDialog->show();
     QString path = m_fileDialog->selectedFiles().first();
-    bool ok = m_pixmap.save(path);
+    setEnabled(false);
+    SaveTask *task = new SaveTask(m_image, path);
+    connect(task, &SaveTask::finished,
+            this, &GraphicalScreenshotSaver::handleSaveFinished);
+    task->start();
+}
+
+void GraphicalScreenshotSaver::handleSaveFinished(bool ok, const QString &path,
+                                                  qint64 elapsed)
+{
     if (ok) {
         QString pathNoFile = path.left(path.lastIndexOf("/"));
         ConfigHandler().setSavePath(pathNoFile);
-        QString msg = QObject::tr("Capture saved as ") + path;
+        QString msg = QObject::tr("Capture saved as %1 in %2 ms")
+                .arg(path).arg(elapsed);
         SystemNotification().sendMessage(msg);
+        ScreenshotSaver().optimizeSavedFile(m_image, path);
         close();
     } else {
+        setEnabled(true);
         QString msg = QObject::tr("Error trying to save as ") + path;
         showErrorMessage(msg);
     }
@@ -19,6 +19,7 @@
 #define GRAPHICALSCREENSHOTSAVER_H
 
 #include <QWidget>
+#include <QImage>
 
 class QFileDialog;
 class QVBoxLayout;
@@ -31,13 +32,14 @@ public:
                                       QWidget *parent = nullptr);
 
 private:
-    QPixmap m_pixmap;
+    QImage m_image;
     QFileDialog *m_fileDialog;
     QVBoxLayout *m_layout;
 
     void initFileDialog();
     void showErrorMessage(const QString &msg);
     void checkSaveAcepted();
+    void handleSaveFinished(bool ok, const QString &path, qint64 elapsed);
 };
 
 #endif // GRAPHICALSCREENSHOTSAVER_H
@@ -22,6 +22,7 @@
 #include "src/capture/workers/imgur/imagelabel.h"
 #include "src/capture/workers/imgur/notificationwidget.h"
 #include "src/utils/confighandler.h"
+#include "src/utils/pngwriter.h"
 #include <QApplication>
 #include <QClipboard>
 #include <QDesktopServices>
@@ -94,7 +95,9 @@ void ImgurUploader::startDrag() {
 void ImgurUploader::upload() {
     QByteArray byteArray;
     QBuffer buffer(&byteArray);
-    m_pixmap.save(&buffer, "PNG");
+    buffer.open(QIODevice::WriteOnly);
+    PngWriter(PngWriter::presetFromName(ConfigHandler().pngCompressionValue()))
+            .write(m_pixmap.toImage(), &buffer);
 
     QUrlQuery urlQuery;
     urlQuery.addQueryItem("title", "flameshot_screenshot");
@@ -0,0 +1,61 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "optimizetask.h"
+#include "src/capture/workers/savetask.h"
+#include "src/utils/pngoptimizer.h"
+#include <QThreadPool>
+#include <QSaveFile>
+#include <QFileInfo>
+
+// OptimizeTask replaces a saved PNG with the smallest one found by
+// PngOptimizer, in the worker threads of SaveTask. The file is only
+// replaced when the result is smaller, the saved bytes are reported by
+// the finished signal. The task deletes itself once finished.
+
+OptimizeTask::OptimizeTask(const QImage &image, const QString &path,
+                           QObject *parent) :
+    QObject(parent), m_image(image), m_path(path)
+{
+    m_timer.start();
+    setAutoDelete(false);
+}
+
+void OptimizeTask::start() {
+    // connected last, after the receivers of the result
+    connect(this, &OptimizeTask::finished, this, &OptimizeTask::deleteLater,
+            Qt::QueuedConnection);
+    SaveTask::pool()->start(this);
+}
+
+void OptimizeTask::run() {
+    QByteArray data = PngOptimizer().optimize(m_image);
+    m_image = QImage();
+    qint64 originalSize = QFileInfo(m_path).size();
+    bool ok = !data.isEmpty();
+    qint64 savedBytes = 0;
+    if (ok && data.size() < originalSize) {
+        // the capture is never left half written
+        QSaveFile file(m_path);
+        ok = file.open(QIODevice::WriteOnly)
+                && file.write(data) == data.size() && file.commit();
+        if (ok) {
+            savedBytes = originalSize - data.size();
+        }
+    }
+    emit finished(ok, m_path, savedBytes, m_timer.elapsed());
+}
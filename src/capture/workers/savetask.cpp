@@ -0,0 +1,62 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "savetask.h"
+#include <QThreadPool>
+
+// SaveTask encodes and writes a capture in a worker thread so the GUI and
+// the DBus interface aren't blocked while a big image is compressed. The
+// format is chosen by ImageEncoder from the extension of the path. The
+// finished signal is received in the thread of the task, the elapsed time
+// is counted from its creation. The task deletes itself once finished.
+
+namespace {
+
+// the encoders are CPU bound, a couple of them is enough to keep up with
+// the captures without competing with the tile rendering
+const int MAX_THREADS = 2;
+
+} // unnamed namespace
+
+Q_GLOBAL_STATIC(QThreadPool, savePool)
+
+SaveTask::SaveTask(const QImage &image, const QString &path,
+                   const ImageEncoder &encoder, QObject *parent) :
+    QObject(parent), m_image(image), m_path(path), m_encoder(encoder)
+{
+    m_timer.start();
+    setAutoDelete(false);
+}
+
+QThreadPool *SaveTask::pool() {
+    QThreadPool *p = savePool();
+    p->setMaxThreadCount(MAX_THREADS);
+    return p;
+}
+
+void SaveTask::start() {
+    // connected last, after the receivers of the result
+    connect(this, &SaveTask::finished, this, &SaveTask::deleteLater,
+            Qt::QueuedConnection);
+    pool()->start(this);
+}
+
+void SaveTask::run() {
+    bool ok = m_encoder.write(m_image, m_path);
+    m_image = QImage();
+    emit finished(ok, m_path, m_timer.elapsed());
+}
@@ -0,0 +1,52 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SAVETASK_H
+#define SAVETASK_H
+
+#include <QObject>
+#include <QRunnable>
+#include <QElapsedTimer>
+#include <QImage>
+#include "src/utils/imageencoder.h"
+
+class QThreadPool;
+
+class SaveTask : public QObject, public QRunnable
+{
+    Q_OBJECT
+public:
+    explicit SaveTask(const QImage &image, const QString &path,
+                      const ImageEncoder &encoder = ImageEncoder(),
+                      QObject *parent = nullptr);
+
+    static QThreadPool* pool();
+
+    void start();
+    void run() override;
+
+signals:
+    void finished(bool ok, const QString &path, qint64 elapsed);
+
+private:
+    QImage m_image;
+    QString m_path;
+    ImageEncoder m_encoder;
+    QElapsedTimer m_timer;
+};
+
+#endif // SAVETASK_H
@@ -16,12 +16,17 @@
 //     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "screenshotsaver.h"
+#include "src/capture/workers/archivetask.h"
+#include "src/capture/workers/savetask.h"
+#include "src/capture/workers/optimizetask.h"
 #include "src/utils/systemnotification.h"
 #include "src/utils/filenamehandler.h"
 #include "src/utils/confighandler.h"
+#include "src/utils/imageencoder.h"
 #include <QClipboard>
 #include <QApplication>
 #include <QMessageBox>
+#include <QFile>
 
 ScreenshotSaver::ScreenshotSaver()
 {
@@ -33,19 +38,106 @@ void ScreenshotSaver::saveToClipboard(const QPixmap &capture) {
 }
 
 void ScreenshotSaver::saveToFilesystem(const QPixmap &capture,
-                                       const QString &path)
+                                       const QString &path,
+                                       const SaveCallback &onSaved)
 {
-    QString completePath = FileNameHandler().generateAbsolutePath(path);
-    completePath += ".png";
-    bool ok = capture.save(completePath);
-    QString saveMessage;
-    if (ok) {
-        ConfigHandler().setSavePath(path);
-        saveMessage = QObject::tr("Capture saved as ") + completePath;
-    } else {
-        saveMessage = QObject::tr("Error trying to save as ") + completePath;
-    }
-    SystemNotification().sendMessage(saveMessage);
+    saveToFilesystem(capture.toImage(), path, onSaved);
+}
+
+// saveToFilesystem encodes and writes the capture in a worker thread, the
+// result is notified when it's written and the callback is called if it
+// succeeded
+void ScreenshotSaver::saveToFilesystem(const QImage &capture,
+                                       const QString &path,
+                                       const SaveCallback &onSaved,
+                                       const int screen)
+{
+    ImageEncoder encoder;
+    // the file is created now so the next capture doesn't take the same
+    // name while this one is being encoded
+    FileNameHandler nameHandler;
+    nameHandler.setCaptureInfo(capture.size(), screen);
+    QString completePath = nameHandler.generateAbsolutePath(
+                path, encoder.format(), FileNameIndex::CREATE);
+    completePath += "." + encoder.format();
+
+    SaveTask *task = new SaveTask(capture, completePath, encoder);
+    QObject::connect(task, &SaveTask::finished, task,
+                     [path, capture, onSaved](bool ok,
+                     const QString &completePath,
+                     qint64 elapsed)
+    {
+        QString saveMessage;
+        if (ok) {
+            ConfigHandler().setSavePath(path);
+            saveMessage = QObject::tr("Capture saved as %1 in %2 ms")
+                    .arg(completePath).arg(elapsed);
+        } else {
+            QFile::remove(completePath);
+            saveMessage = QObject::tr("Error trying to save as ") + completePath;
+        }
+        SystemNotification().sendMessage(saveMessage);
+        if (ok) {
+            if (onSaved) {
+                onSaved(completePath, elapsed);
+            }
+            ScreenshotSaver().optimizeSavedFile(capture, completePath);
+        }
+    });
+    task->start();
 }
 
+// optimizeSavedFile replaces a saved PNG with a smaller one in a worker
+// thread when the optimization is enabled, the saved bytes are notified
+void ScreenshotSaver::optimizeSavedFile(const QImage &capture,
+                                        const QString &path)
+{
+    if (!path.endsWith(".png", Qt::CaseInsensitive)
+            || !ConfigHandler().optimizePngValue())
+    {
+        return;
+    }
+    OptimizeTask *task = new OptimizeTask(capture, path);
+    QObject::connect(task, &OptimizeTask::finished, task,
+                     [](bool ok, const QString &path, qint64 savedBytes,
+                     qint64 elapsed)
+    {
+        QString message;
+        if (ok) {
+            message = QObject::tr("%1 optimized in %2 ms, %3 KB saved")
+                    .arg(path).arg(elapsed).arg(savedBytes / 1024);
+        } else {
+            message = QObject::tr("Error trying to optimize ") + path;
+        }
+        SystemNotification().sendMessage(message);
+    });
+    task->start();
+}
 
+// saveToArchive appends the capture to a tile archive in a worker thread,
+// only the tiles which changed since the previous capture of the archive
+// are stored. The result is notified when it's written.
+void ScreenshotSaver::saveToArchive(const QImage &capture,
+                                    const QString &archivePath,
+                                    const int keyframeInterval)
+{
+    ArchiveTask *task = new ArchiveTask(capture, archivePath,
+                                        keyframeInterval);
+    QObject::connect(task, &ArchiveTask::finished, task,
+                     [](int tiles, const QString &archivePath,
+                     const QString &errorString, qint64 elapsed)
+    {
+        QString saveMessage;
+        if (tiles >= 0) {
+            saveMessage = QObject::tr("Capture added to %1 in %2 ms, "
+                                      "%3 tiles stored")
+                    .arg(archivePath).arg(elapsed).arg(tiles);
+        } else {
+            saveMessage = QObject::tr("Error trying to add the capture to "
+                                      "%1: %2")
+                    .arg(archivePath).arg(errorString);
+        }
+        SystemNotification().sendMessage(saveMessage);
+    });
+    task->start();
+}
@@ -18,7 +18,11 @@
 #ifndef SCREENSHOTSAVER_H
 #define SCREENSHOTSAVER_H
 
+#include <QtGlobal>
+#include <functional>
+
 class QPixmap;
+class QImage;
 class QString;
 
 class ScreenshotSaver
@@ -26,8 +30,18 @@ class ScreenshotSaver
 public:
     ScreenshotSaver();
 
+    // receives the path of the saved capture and the milliseconds taken
+    using SaveCallback = std::function<void(const QString &, qint64)>;
+
     void saveToClipboard(const QPixmap &capture);
-    void saveToFilesystem(const QPixmap &capture, const QString &path);
+    void saveToFilesystem(const QPixmap &capture, const QString &path,
+                          const SaveCallback &onSaved = SaveCallback());
+    void saveToFilesystem(const QImage &capture, const QString &path,
+                          const SaveCallback &onSaved = SaveCallback(),
+                          const int screen = -1);
+    void optimizeSavedFile(const QImage &capture, const QString &path);
+    void saveToArchive(const QImage &capture, const QString &archivePath,
+                       const int keyframeInterval);
 
 };
 
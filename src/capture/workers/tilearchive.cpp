@@ -0,0 +1,476 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "tilearchive.h"
+#include "src/capture/tiledimage.h"
+#include <QtConcurrent>
+#include <QDataStream>
+#include <QFile>
+#include <QLockFile>
+#include <QtEndian>
+
+// TileArchive stores a series of captures in one file. Every frame is split
+// in tiles of TiledImage::TILE_SIZE pixels and only the tiles whose hash
+// changed since the previous frame are stored, compressed. Every
+// keyframeInterval frames, and when the size changes, a keyframe with all
+// the tiles is stored so a frame can be rebuilt from the previous keyframe.
+//
+// Layout, written with QDataStream:
+//   header: magic, version, frame count, offset of the last frame
+//   frame:  magic, size of the rest of the frame, width, height, keyframe,
+//           tile count, hash of every tile, changed tile count,
+//           (tile index, compressed pixels) of every changed tile
+// The header lets append read the hashes of the last frame without reading
+// the previous ones. It is updated after writing a frame, the data after
+// the frames it counts is ignored.
+// The archive is locked while it is read or written, with a lock file next
+// to it, so concurrent captures can append to it.
+
+namespace {
+
+const quint32 ARCHIVE_MAGIC = 0x46535441; // FSTA
+const quint32 FRAME_MAGIC = 0x46524d45; // FRME
+const quint32 VERSION = 2;
+const int TILE_SIZE = TiledImage::TILE_SIZE;
+// the frames of a series of captures are similar, a fast level is enough
+const int COMPRESSION_LEVEL = 3;
+
+// size of the header of the archive and of the fields of a frame before
+// its size
+const qint64 HEADER_SIZE = 20;
+const qint64 FRAME_PREFIX_SIZE = 12;
+// time waiting for another process to release the archive
+const int LOCK_TIMEOUT = 10000;
+// longest side of a frame, the limit of the raster painting
+const quint32 MAX_FRAME_SIDE = 32767;
+
+inline quint64 rotateLeft(const quint64 x, const int bits) {
+    return (x << bits) | (x >> (64 - bits));
+}
+
+// hashTile returns a 64 bit hash of the pixels of a tile
+quint64 hashTile(const QImage &image, const QRect &rect) {
+    const quint64 k1 = 0x87c37b91114253d5ULL;
+    const quint64 k2 = 0x4cf5ad432745937fULL;
+    quint64 h = 0x9e3779b97f4a7c15ULL ^ (quint64(rect.width()) << 32)
+            ^ quint64(rect.height());
+    for (int y = rect.top(); y <= rect.bottom(); ++y) {
+        const quint32 *line = reinterpret_cast<const quint32 *>(
+                    image.constScanLine(y)) + rect.left();
+        for (int x = 0; x < rect.width(); ++x) {
+            h ^= line[x] * k1;
+            h = rotateLeft(h, 31) * k2;
+        }
+    }
+    // final mix
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+QRect tileRect(const QSize &size, const int index) {
+    int columns = (size.width() + TILE_SIZE - 1) / TILE_SIZE;
+    QRect r((index % columns) * TILE_SIZE, (index / columns) * TILE_SIZE,
+            TILE_SIZE, TILE_SIZE);
+    return r.intersected(QRect(QPoint(0, 0), size));
+}
+
+int tileCount(const QSize &size) {
+    return ((size.width() + TILE_SIZE - 1) / TILE_SIZE)
+            * ((size.height() + TILE_SIZE - 1) / TILE_SIZE);
+}
+
+// framePath returns the path of an extracted frame, numbered with the
+// digits of the last frame
+QString framePath(const QString &pathPrefix, const int frame,
+                  const int frameCount)
+{
+    int digits = QString::number(frameCount - 1).size();
+    return QStringLiteral("%1_%2.png").arg(pathPrefix)
+            .arg(frame, digits, 10, QLatin1Char('0'));
+}
+
+struct TileData {
+    int index;
+    QRect rect;
+    QByteArray data;
+};
+
+} // unnamed namespace
+
+TileArchive::TileArchive(const QString &path) : m_path(path) {
+
+}
+
+// append adds a frame at the end of the archive, creating it if it doesn't
+// exist. It returns the number of stored tiles or -1 in case of error.
+int TileArchive::append(const QImage &frame, const int keyframeInterval) {
+    QLockFile lockFile(m_path + QStringLiteral(".lock"));
+    if (!lock(lockFile)) {
+        return -1;
+    }
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadWrite)) {
+        m_errorString = file.errorString();
+        return -1;
+    }
+    QDataStream stream(&file);
+    Header header;
+    header.frameCount = 0;
+    header.lastFrameOffset = 0;
+    FrameEntry last;
+    last.end = HEADER_SIZE;
+    if (file.size() == 0) {
+        stream << ARCHIVE_MAGIC << VERSION << quint32(0) << quint64(0);
+    } else {
+        if (!readHeader(file, header)) {
+            return -1;
+        }
+        if (header.frameCount > 0
+                && !readEntry(file, header.lastFrameOffset, last)) {
+            return -1;
+        }
+    }
+
+    QImage image = frame.convertToFormat(QImage::Format_RGB32);
+    int count = tileCount(image.size());
+    QVector<quint64> hashes(count);
+    for (int i = 0; i < count; ++i) {
+        hashes[i] = hashTile(image, tileRect(image.size(), i));
+    }
+
+    bool keyframe = header.frameCount == 0
+            || header.frameCount % qMax(keyframeInterval, 1) == 0
+            || last.size != image.size();
+    QVector<quint64> previousHashes;
+    if (!keyframe && !readHashes(file, last, previousHashes)) {
+        return -1;
+    }
+    QVector<TileData> tiles;
+    for (int i = 0; i < count; ++i) {
+        if (keyframe || hashes.at(i) != previousHashes.value(i)) {
+            TileData tile;
+            tile.index = i;
+            tile.rect = tileRect(image.size(), i);
+            tiles << tile;
+        }
+    }
+    // the changed tiles are compressed in parallel
+    QtConcurrent::blockingMap(tiles, [&image](TileData &tile) {
+        QByteArray raw;
+        raw.reserve(tile.rect.width() * tile.rect.height() * 4);
+        for (int y = tile.rect.top(); y <= tile.rect.bottom(); ++y) {
+            raw.append(reinterpret_cast<const char *>(image.constScanLine(y))
+                       + tile.rect.left() * 4, tile.rect.width() * 4);
+        }
+        tile.data = qCompress(raw, COMPRESSION_LEVEL);
+    });
+
+    QByteArray record;
+    QDataStream recordStream(&record, QIODevice::WriteOnly);
+    recordStream << quint32(image.width()) << quint32(image.height())
+                 << quint8(keyframe) << quint32(count);
+    for (const quint64 hash: hashes) {
+        recordStream << hash;
+    }
+    recordStream << quint32(tiles.size());
+    for (const TileData &tile: tiles) {
+        recordStream << quint32(tile.index) << tile.data;
+    }
+
+    // the frame is written after the last one, replacing the data of an
+    // append which didn't finish, and then it is added to the header
+    file.seek(last.end);
+    stream << FRAME_MAGIC << quint64(record.size());
+    if (stream.writeRawData(record.constData(), record.size()) != record.size()
+            || !file.resize(last.end + FRAME_PREFIX_SIZE + record.size())
+            || !file.flush())
+    {
+        m_errorString = file.errorString();
+        return -1;
+    }
+    file.seek(0);
+    stream << ARCHIVE_MAGIC << VERSION << quint32(header.frameCount + 1)
+           << quint64(last.end);
+    if (stream.status() != QDataStream::Ok || !file.flush()) {
+        m_errorString = file.errorString();
+        return -1;
+    }
+    return tiles.size();
+}
+
+int TileArchive::frameCount() {
+    QLockFile lockFile(m_path + QStringLiteral(".lock"));
+    if (!lock(lockFile)) {
+        return -1;
+    }
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_errorString = file.errorString();
+        return -1;
+    }
+    QVector<FrameEntry> entries;
+    return readEntries(file, entries) ? entries.size() : -1;
+}
+
+// extract rebuilds a frame from the previous keyframe, it returns a null
+// image in case of error
+QImage TileArchive::extract(const int frame) {
+    QVector<FrameEntry> entries;
+    return extract(frame, entries);
+}
+
+// extractFrame saves a frame as a PNG named like the ones of extractAll, it
+// returns the path or an empty string in case of error
+QString TileArchive::extractFrame(const int frame, const QString &pathPrefix) {
+    QVector<FrameEntry> entries;
+    QImage image = extract(frame, entries);
+    if (image.isNull()) {
+        return QString();
+    }
+    QString path = framePath(pathPrefix, frame, entries.size());
+    if (!image.save(path, "PNG")) {
+        m_errorString = QObject::tr("Error trying to save as ") + path;
+        return QString();
+    }
+    return path;
+}
+
+// extractAll saves every frame as a PNG named with the prefix and the
+// number of the frame. The frames are rebuilt in order, each one from the
+// previous.
+bool TileArchive::extractAll(const QString &pathPrefix) {
+    QLockFile lockFile(m_path + QStringLiteral(".lock"));
+    if (!lock(lockFile)) {
+        return false;
+    }
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_errorString = file.errorString();
+        return false;
+    }
+    QVector<FrameEntry> entries;
+    if (!readEntries(file, entries)) {
+        return false;
+    }
+    QImage image;
+    for (int i = 0; i < entries.size(); ++i) {
+        if (entries.at(i).keyframe) {
+            image = QImage(entries.at(i).size, QImage::Format_RGB32);
+        }
+        if (!applyFrame(file, entries.at(i), image)) {
+            return false;
+        }
+        QString path = framePath(pathPrefix, i, entries.size());
+        if (!image.save(path, "PNG")) {
+            m_errorString = QObject::tr("Error trying to save as ") + path;
+            return false;
+        }
+    }
+    return true;
+}
+
+QString TileArchive::errorString() const {
+    return m_errorString;
+}
+
+QImage TileArchive::extract(const int frame, QVector<FrameEntry> &entries) {
+    QLockFile lockFile(m_path + QStringLiteral(".lock"));
+    if (!lock(lockFile)) {
+        return QImage();
+    }
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_errorString = file.errorString();
+        return QImage();
+    }
+    if (!readEntries(file, entries)) {
+        return QImage();
+    }
+    if (frame < 0 || frame >= entries.size()) {
+        m_errorString = QObject::tr("The frame doesn't exist");
+        return QImage();
+    }
+    int keyframe = frame;
+    while (!entries.at(keyframe).keyframe) {
+        --keyframe;
+    }
+    QImage image(entries.at(keyframe).size, QImage::Format_RGB32);
+    for (int i = keyframe; i <= frame; ++i) {
+        if (!applyFrame(file, entries.at(i), image)) {
+            return QImage();
+        }
+    }
+    return image;
+}
+
+// lock waits until no other process reads or writes the archive
+bool TileArchive::lock(QLockFile &lockFile) {
+    if (!lockFile.tryLock(LOCK_TIMEOUT)) {
+        m_errorString = QObject::tr("The tile archive is used by another "
+                                    "process");
+        return false;
+    }
+    return true;
+}
+
+bool TileArchive::readHeader(QFile &file, Header &header) {
+    QDataStream stream(&file);
+    file.seek(0);
+    quint32 magic, version, frameCount;
+    quint64 lastFrameOffset;
+    stream >> magic >> version;
+    if (stream.status() != QDataStream::Ok || magic != ARCHIVE_MAGIC
+            || version != VERSION)
+    {
+        m_errorString = QObject::tr("The file isn't a tile archive");
+        return false;
+    }
+    stream >> frameCount >> lastFrameOffset;
+    if (stream.status() != QDataStream::Ok
+            || lastFrameOffset > quint64(file.size()))
+    {
+        m_errorString = QObject::tr("The tile archive is corrupted");
+        return false;
+    }
+    header.frameCount = frameCount;
+    header.lastFrameOffset = lastFrameOffset;
+    return true;
+}
+
+// readEntry reads the position and the size of the frame at the offset
+bool TileArchive::readEntry(QFile &file, const qint64 offset,
+                            FrameEntry &entry)
+{
+    QDataStream stream(&file);
+    quint32 magic;
+    quint64 size;
+    quint32 width, height;
+    quint8 keyframe;
+    file.seek(offset);
+    stream >> magic >> size >> width >> height >> keyframe;
+    if (stream.status() != QDataStream::Ok || magic != FRAME_MAGIC
+            || offset + FRAME_PREFIX_SIZE + size > quint64(file.size())
+            || width == 0 || width > MAX_FRAME_SIDE
+            || height == 0 || height > MAX_FRAME_SIDE)
+    {
+        m_errorString = QObject::tr("The tile archive is corrupted");
+        return false;
+    }
+    entry.offset = offset;
+    entry.end = offset + FRAME_PREFIX_SIZE + static_cast<qint64>(size);
+    entry.size = QSize(width, height);
+    entry.keyframe = keyframe;
+    return true;
+}
+
+// readEntries reads the position and the size of every frame
+bool TileArchive::readEntries(QFile &file, QVector<FrameEntry> &entries) {
+    Header header;
+    if (!readHeader(file, header)) {
+        return false;
+    }
+    qint64 offset = HEADER_SIZE;
+    for (int i = 0; i < header.frameCount; ++i) {
+        FrameEntry entry;
+        if (!readEntry(file, offset, entry)) {
+            return false;
+        }
+        entries << entry;
+        offset = entry.end;
+    }
+    if (!entries.isEmpty() && !entries.first().keyframe) {
+        m_errorString = QObject::tr("The tile archive is corrupted");
+        return false;
+    }
+    return true;
+}
+
+// readHashes reads the hashes of the tiles of a frame, their count is
+// checked against the size of the frame before allocating them
+bool TileArchive::readHashes(QFile &file, const FrameEntry &entry,
+                             QVector<quint64> &hashes)
+{
+    QDataStream stream(&file);
+    // skip the size and the keyframe flag
+    qint64 position = entry.offset + FRAME_PREFIX_SIZE + 9;
+    file.seek(position);
+    quint32 count;
+    stream >> count;
+    qint64 available = entry.end - position - 4;
+    if (stream.status() != QDataStream::Ok
+            || count != quint32(tileCount(entry.size))
+            || qint64(count) * qint64(sizeof(quint64)) > available)
+    {
+        m_errorString = QObject::tr("The tile archive is corrupted");
+        return false;
+    }
+    hashes.resize(count);
+    for (quint32 i = 0; i < count; ++i) {
+        stream >> hashes[i];
+    }
+    if (stream.status() != QDataStream::Ok) {
+        m_errorString = QObject::tr("The tile archive is corrupted");
+        return false;
+    }
+    return true;
+}
+
+// applyFrame writes the tiles stored in a frame in the image
+bool TileArchive::applyFrame(QFile &file, const FrameEntry &entry,
+                             QImage &image)
+{
+    QVector<quint64> hashes;
+    if (image.size() != entry.size || !readHashes(file, entry, hashes)) {
+        m_errorString = QObject::tr("The tile archive is corrupted");
+        return false;
+    }
+    QDataStream stream(&file);
+    quint32 changed;
+    stream >> changed;
+    for (quint32 i = 0; i < changed; ++i) {
+        quint32 index;
+        QByteArray data;
+        stream >> index >> data;
+        QRect rect = tileRect(image.size(), index);
+        const int rawSize = rect.width() * rect.height() * 4;
+        // qUncompress allocates the size stored before the data
+        if (stream.status() != QDataStream::Ok
+                || index >= quint32(hashes.size()) || data.size() < 4
+                || qFromBigEndian<quint32>(
+                    reinterpret_cast<const uchar *>(data.constData()))
+                != quint32(rawSize))
+        {
+            m_errorString = QObject::tr("The tile archive is corrupted");
+            return false;
+        }
+        QByteArray raw = qUncompress(data);
+        if (raw.size() != rawSize) {
+            m_errorString = QObject::tr("The tile archive is corrupted");
+            return false;
+        }
+        int lineSize = rect.width() * 4;
+        for (int y = 0; y < rect.height(); ++y) {
+            memcpy(image.scanLine(rect.top() + y) + rect.left() * 4,
+                   raw.constData() + y * lineSize, lineSize);
+        }
+    }
+    return true;
+}
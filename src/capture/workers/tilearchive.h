@@ -0,0 +1,70 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TILEARCHIVE_H
+#define TILEARCHIVE_H
+
+#include <QImage>
+#include <QString>
+#include <QVector>
+
+class QFile;
+class QLockFile;
+
+class TileArchive
+{
+public:
+    explicit TileArchive(const QString &path);
+
+    static const int DEFAULT_KEYFRAME_INTERVAL = 30;
+
+    int append(const QImage &frame,
+               const int keyframeInterval = DEFAULT_KEYFRAME_INTERVAL);
+    int frameCount();
+    QImage extract(const int frame);
+    QString extractFrame(const int frame, const QString &pathPrefix);
+    bool extractAll(const QString &pathPrefix);
+    QString errorString() const;
+
+private:
+    struct FrameEntry {
+        qint64 offset;
+        // offset of the next frame
+        qint64 end;
+        QSize size;
+        bool keyframe;
+    };
+
+    struct Header {
+        int frameCount;
+        qint64 lastFrameOffset;
+    };
+
+    QString m_path;
+    QString m_errorString;
+
+    QImage extract(const int frame, QVector<FrameEntry> &entries);
+    bool lock(QLockFile &lockFile);
+    bool readHeader(QFile &file, Header &header);
+    bool readEntry(QFile &file, const qint64 offset, FrameEntry &entry);
+    bool readEntries(QFile &file, QVector<FrameEntry> &entries);
+    bool readHashes(QFile &file, const FrameEntry &entry,
+                    QVector<quint64> &hashes);
+    bool applyFrame(QFile &file, const FrameEntry &entry, QImage &image);
+};
+
+#endif // TILEARCHIVE_H
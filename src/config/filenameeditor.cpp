@@ -53,7 +53,8 @@ void FileNameEditor::initWidgets() {
 
     // editor
     m_nameEditor = new QLineEdit(this);
-    m_nameEditor->setMaxLength(FileNameHandler::MAX_CHARACTERS);
+    // the names are cut at MAX_LENGTH bytes, a longer pattern can't be used
+    m_nameEditor->setMaxLength(FileNamePattern::MAX_LENGTH);
 
     // preview
     m_outputLabel = new QLineEdit(this);
@@ -96,8 +97,8 @@ void FileNameEditor::savePattern() {
 }
 
 void FileNameEditor::showParsedPattern(const QString &p) {
-    QString output = m_nameHandler->parseFilename(p);
-    m_outputLabel->setText(output);
+    m_previewPattern = FileNamePattern(p);
+    m_outputLabel->setText(m_nameHandler->expand(m_previewPattern));
 }
 
 void FileNameEditor::resetName() {
@@ -18,6 +18,7 @@
 #ifndef FILENAMEEDITOR_H
 #define FILENAMEEDITOR_H
 
+#include "src/utils/filenamepattern.h"
 #include <QGroupBox>
 #include <QPointer>
 
@@ -38,6 +39,8 @@ private:
     QLineEdit *m_outputLabel;
     QLineEdit *m_nameEditor;
     FileNameHandler *m_nameHandler;
+    // pattern being edited, apart from the configured one
+    FileNamePattern m_previewPattern;
     StrftimeChooserWidget *m_helperButtons;
     QPushButton *m_saveButton;
     QPushButton *m_resetButton;
@@ -23,10 +23,10 @@
 StrftimeChooserWidget::StrftimeChooserWidget(QWidget *parent) : QWidget(parent) {
     QGridLayout *layout = new QGridLayout(this);
     auto k = m_buttonData.keys();
-    int middle = k.length()/2;
-    // add the buttons in 2 columns (they need to be even)
+    int middle = (k.length() + 1)/2;
+    // add the buttons in 2 columns, the second one can be shorter
     for (int i = 0; i < 2; i++) {
-        for (int j = 0; j < middle; j++) {
+        for (int j = 0; j < middle && !k.isEmpty(); j++) {
             QString key = k.last();
             k.pop_back();
             QString variable = m_buttonData.value(key);
@@ -65,4 +65,8 @@ QMap<QString, QString> StrftimeChooserWidget::m_buttonData {
     { QT_TR_NOOP("Second (00-59)"),         "%S"},
     { QT_TR_NOOP("Full Date (%m/%d/%y)"),   "%D"},
     { QT_TR_NOOP("Full Date (%Y-%m-%d)"),   "%F"},
+    { QT_TR_NOOP("Capture Number"),         "%{seq}"},
+    { QT_TR_NOOP("Capture Width"),          "%{w}"},
+    { QT_TR_NOOP("Capture Height"),         "%{h}"},
+    { QT_TR_NOOP("Screen Number"),          "%{screen}"},
 };
@@ -18,6 +18,7 @@
 #include "controller.h"
 #include "src/capture/widget/capturewidget.h"
 #include "src/utils/confighandler.h"
+#include "src/utils/filenamehandler.h"
 #include "src/infowindow.h"
 #include "src/config/configwindow.h"
 #include "src/capture/widget/capturebutton.h"
@@ -26,11 +27,13 @@
 #include <QSystemTrayIcon>
 #include <QAction>
 #include <QMenu>
+#include <QFileSystemWatcher>
 
 // Controller is the core component of Flameshot, creates the trayIcon and
 // launches the capture widget
 
-Controller::Controller() : m_captureWindow(nullptr)
+Controller::Controller() : m_captureWindow(nullptr),
+    m_captureConfigOutdated(false)
 {
     qApp->setQuitOnLastWindowClosed(false);
 
@@ -43,6 +46,14 @@ Controller::Controller() : m_captureWindow(nullptr)
 
     QString StyleSheet = CaptureButton::globalStyleSheet();
     qApp->setStyleSheet(StyleSheet);
+
+    // the capture widget is created in advance so a capture only has to
+    // grab the screens and show it, it's updated when the config changes
+    createCaptureWindow();
+    m_configWatcher = new QFileSystemWatcher(this);
+    m_configWatcher->addPath(ConfigHandler().configFilePath());
+    connect(m_configWatcher, &QFileSystemWatcher::fileChanged,
+            this, &Controller::handleConfigChange);
 }
 
 Controller *Controller::getInstance() {
@@ -60,12 +71,38 @@ void Controller::initDefaults() {
     }
 }
 
+// handleConfigChange updates the capture widget with the new config, it
+// waits for the end of the current capture
+void Controller::handleConfigChange(const QString &path) {
+    // the file can be replaced when it's saved
+    m_configWatcher->removePath(path);
+    m_configWatcher->addPath(path);
+    FileNameHandler::invalidatePattern();
+    if (m_captureWindow && m_captureWindow->isVisible()) {
+        m_captureConfigOutdated = true;
+    } else if (m_captureWindow) {
+        m_captureWindow->updateConfig();
+    }
+}
+
+void Controller::createCaptureWindow() {
+    m_captureWindow = new CaptureWidget();
+    connect(m_captureWindow, &CaptureWidget::captureCompleted,
+            this, &Controller::captureCompleted);
+}
+
 // creation of a new capture in GUI mode
 void Controller::createVisualCapture(const QString &forcedSavePath) {
     if (!m_captureWindow) {
-        m_captureWindow = new CaptureWidget(forcedSavePath);
-        m_captureWindow->showFullScreen();
+        createCaptureWindow();
+    } else if (m_captureWindow->isVisible()) {
+        return;
+    }
+    if (m_captureConfigOutdated) {
+        m_captureConfigOutdated = false;
+        m_captureWindow->updateConfig();
     }
+    m_captureWindow->startCapture(forcedSavePath);
 }
 
 // creation of the configuration window
@@ -20,11 +20,13 @@
 
 #include <QObject>
 #include <QPointer>
+#include <QVariantMap>
 
 class CaptureWidget;
 class ConfigWindow;
 class InfoWindow;
 class QSystemTrayIcon;
+class QFileSystemWatcher;
 
 class Controller : public QObject {
     Q_OBJECT
@@ -35,6 +37,9 @@ public:
     Controller(const Controller&) = delete;
     void operator =(const Controller&) = delete;
 
+signals:
+    void captureCompleted(const QString &location, const QVariantMap &timings);
+
 public slots:
     void createVisualCapture(const QString &forcedSavePath = QString());
 
@@ -48,14 +53,20 @@ public slots:
 
 private slots:
     void initDefaults();
+    void handleConfigChange(const QString &path);
 
 private:
     Controller();
 
+    void createCaptureWindow();
+
     QPointer<CaptureWidget> m_captureWindow;
     QPointer<InfoWindow> m_infoWindow;
     QPointer<ConfigWindow> m_configWindow;
     QPointer<QSystemTrayIcon> m_trayIcon;
+    QFileSystemWatcher *m_configWatcher;
+    // the config changed during a capture
+    bool m_captureConfigOutdated;
 
 };
 
@@ -20,7 +20,13 @@
 #include "src/utils/screengrabber.h"
 #include "src/core/controller.h"
 #include "src/core/resourceexporter.h"
+#include "src/utils/systemnotification.h"
+#include "src/capture/workers/burstcapture.h"
+#include "src/utils/pngwriter.h"
+#include "src/utils/sealedimage.h"
 #include <QTimer>
+#include <QPixmap>
+#include <QBuffer>
 #include <functional>
 
 namespace {
@@ -36,11 +42,63 @@ namespace {
         timer->setInterval(msec);
         timer->start();
     }
+
+    // captureData refuses bigger captures, the messages of the session bus
+    // are limited to 128 MiB by default and often to less
+    const int MAX_CAPTURE_DATA_SIZE = 32 * 1024 * 1024;
+
+    // grabCapture grabs a screen, an area or the whole desktop, the area
+    // is relative to the screen when one is selected
+    TiledImage grabCapture(int screen, const QRect &area) {
+        ScreenGrabber grabber;
+        if (screen >= 0) {
+            return grabber.grabScreen(screen, area);
+        } else if (area.isEmpty()) {
+            return grabber.grabDesktop();
+        } else {
+            return grabber.grabArea(area);
+        }
+    }
+}
+
+// encodeCapture returns a capture as PNG, PPM or raw rows of 32 bit
+// pixels (0xffRRGGBB). The raw and PPM pixels are composed straight
+// in the returned array.
+QByteArray FlameshotDBusAdapter::encodeCapture(const TiledImage &capture,
+                                               const QString &format)
+{
+    const QSize size = capture.size();
+    QByteArray data;
+    if (format == "png") {
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        PngWriter(PngWriter::presetFromName(
+                      ConfigHandler().pngCompressionValue()))
+                .write(capture.toImage(), &buffer);
+    } else if (format == "raw") {
+        data.resize(size.width() * size.height() * 4);
+        QImage target(reinterpret_cast<uchar *>(data.data()),
+                      size.width(), size.height(), size.width() * 4,
+                      QImage::Format_RGB32);
+        capture.copyTo(target);
+    } else if (format == "ppm") {
+        data = QStringLiteral("P6\n%1 %2\n255\n").arg(size.width())
+                .arg(size.height()).toLatin1();
+        int headerSize = data.size();
+        data.resize(headerSize + size.width() * size.height() * 3);
+        QImage target(reinterpret_cast<uchar *>(data.data() + headerSize),
+                      size.width(), size.height(), size.width() * 3,
+                      QImage::Format_RGB888);
+        capture.copyTo(target);
+    }
+    return data;
 }
 
 FlameshotDBusAdapter::FlameshotDBusAdapter(QObject *parent)
     : QDBusAbstractAdaptor(parent)
 {
+    connect(Controller::getInstance(), &Controller::captureCompleted,
+            this, &FlameshotDBusAdapter::captureCompleted);
 
 }
 
@@ -58,21 +116,145 @@ void FlameshotDBusAdapter::graphicCapture(QString path, int delay) {
 }
 
 void FlameshotDBusAdapter::fullScreen(QString path, bool toClipboard, int delay) {
-    auto f = [path, toClipboard, this]() {
-        QPixmap p(ScreenGrabber().grabEntireDesktop());
+    fullScreenArea(path, toClipboard, delay, -1, 0, 0, 0, 0);
+}
+
+// fullScreenArea takes a screenshot of the desktop, a screen or an area. A
+// negative screen means every screen and an empty area the whole screen,
+// the area is relative to the screen when one is selected. Only the pixels
+// of the area are grabbed and saved.
+void FlameshotDBusAdapter::fullScreenArea(QString path, bool toClipboard,
+                                          int delay, int screen, int x, int y,
+                                          int width, int height)
+{
+    auto f = [path, toClipboard, screen, x, y, width, height, this]() {
+        TiledImage capture = grabCapture(screen, QRect(x, y, width, height));
+        if (capture.isNull()) {
+            SystemNotification().sendMessage(
+                        tr("The screen or the area to capture doesn't exist"));
+            return;
+        }
+        QImage image = capture.toImage();
         if(toClipboard) {
-            ResourceExporter().captureToClipboard(p);
+            ResourceExporter().captureToClipboard(QPixmap::fromImage(image));
         }
         if(path.isEmpty()) {
-            ResourceExporter().captureToFileUi(p);
+            ResourceExporter().captureToFileUi(QPixmap::fromImage(image));
         } else {
-            ResourceExporter().captureToFile(p, path);
+            // saved from the image, the pixmap isn't needed
+            ResourceExporter().captureToFile(image, path, screen);
         }
     };
     //QTimer::singleShot(delay, this, f); // // requires Qt 5.4
     doLater(delay, this, f);
 }
 
+// burstCapture takes count screenshots separated by interval milliseconds,
+// the screen and the area work like in fullScreenArea
+void FlameshotDBusAdapter::burstCapture(QString path, int delay, int interval,
+                                        int count, int screen, int x, int y,
+                                        int width, int height)
+{
+    auto f = [=]() {
+        auto burst = new BurstCapture(path, interval, count, screen,
+                                      QRect(x, y, width, height), this);
+        burst->start();
+    };
+    doLater(delay, this, f);
+}
+
+// archiveCapture takes a screenshot like fullScreenArea and appends it to a
+// tile archive, which is created if it doesn't exist
+void FlameshotDBusAdapter::archiveCapture(QString archivePath,
+                                          int keyframeInterval, int delay,
+                                          int screen, int x, int y,
+                                          int width, int height)
+{
+    auto f = [=]() {
+        TiledImage capture = grabCapture(screen, QRect(x, y, width, height));
+        if (capture.isNull()) {
+            SystemNotification().sendMessage(
+                        tr("The screen or the area to capture doesn't exist"));
+            return;
+        }
+        ResourceExporter().captureToArchive(capture.toImage(), archivePath,
+                                            keyframeInterval);
+    };
+    doLater(delay, this, f);
+}
+
+// captureData takes a screenshot like fullScreenArea and returns it as
+// png, ppm or raw 32 bit pixels, the size of the image is also returned.
+// An empty array is returned when the area doesn't exist, an error when the
+// format is unknown. The captures bigger than MAX_CAPTURE_DATA_SIZE don't
+// fit in a message, an error is returned for them and
+// captureFileDescriptor has to be used instead.
+QByteArray FlameshotDBusAdapter::captureData(QString format, int screen,
+                                             int x, int y, int width,
+                                             int height, int &imageWidth,
+                                             int &imageHeight)
+{
+    imageWidth = 0;
+    imageHeight = 0;
+    if (format != "png" && format != "ppm" && format != "raw") {
+        sendErrorReply(QDBusError::InvalidArgs,
+                       tr("Unknown format %1, use png, ppm or raw")
+                       .arg(format));
+        return QByteArray();
+    }
+    TiledImage capture = grabCapture(screen, QRect(x, y, width, height));
+    imageWidth = capture.size().width();
+    imageHeight = capture.size().height();
+    if (capture.isNull()) {
+        return QByteArray();
+    }
+    // the size of the raw and PPM captures is known before composing them,
+    // the PNG ones are limited by their raw size so a capture which would be
+    // refused isn't encoded in the GUI thread
+    qint64 pixelsSize = static_cast<qint64>(imageWidth) * imageHeight
+            * (format == "ppm" ? 3 : 4);
+    QByteArray data;
+    if (pixelsSize <= MAX_CAPTURE_DATA_SIZE) {
+        data = encodeCapture(capture, format);
+    }
+    if (pixelsSize > MAX_CAPTURE_DATA_SIZE
+            || data.size() > MAX_CAPTURE_DATA_SIZE)
+    {
+        sendErrorReply(QDBusError::LimitsExceeded,
+                       tr("The capture is bigger than %1 MiB, use "
+                          "captureFileDescriptor instead")
+                       .arg(MAX_CAPTURE_DATA_SIZE / (1024 * 1024)));
+        return QByteArray();
+    }
+    return data;
+}
+
+// captureFileDescriptor takes a screenshot like fullScreenArea and returns
+// a sealed memory file with its pixels, which the caller can map. The
+// metadata describes the layout of the pixels.
+QDBusUnixFileDescriptor FlameshotDBusAdapter::captureFileDescriptor(
+        int screen, int x, int y, int width, int height, int &imageWidth,
+        int &imageHeight, int &stride, QString &format)
+{
+    TiledImage capture = grabCapture(screen, QRect(x, y, width, height));
+    if (capture.isNull()) {
+        sendErrorReply(QDBusError::InvalidArgs,
+                       tr("The screen or the area to capture doesn't exist"));
+        return QDBusUnixFileDescriptor();
+    }
+    SealedImage image(capture);
+    if (!image.isValid()) {
+        sendErrorReply(QDBusError::Failed, image.errorString());
+        return QDBusUnixFileDescriptor();
+    }
+    imageWidth = image.size().width();
+    imageHeight = image.size().height();
+    stride = image.stride();
+    format = SealedImage::FORMAT;
+    // the descriptor is duplicated, the original is closed with the image
+    return QDBusUnixFileDescriptor(image.fileDescriptor());
+}
+
 void FlameshotDBusAdapter::openConfig() {
     Controller::getInstance()->openConfigWindow();
 }
@@ -19,9 +19,14 @@
 #define FLAMESHOTDBUSADAPTER_H
 
 #include <QtDBus/QDBusAbstractAdaptor>
+#include <QtDBus/QDBusContext>
+#include <QtDBus/QDBusUnixFileDescriptor>
+#include <QVariantMap>
 #include "src/core/controller.h"
 
-class FlameshotDBusAdapter : public QDBusAbstractAdaptor
+class TiledImage;
+
+class FlameshotDBusAdapter : public QDBusAbstractAdaptor, protected QDBusContext
 {
     Q_OBJECT
     Q_CLASSINFO("D-Bus Interface", "org.dharkael.Flameshot")
@@ -30,9 +35,33 @@ public:
     FlameshotDBusAdapter(QObject *parent = nullptr);
     virtual ~FlameshotDBusAdapter();
 
+    static QByteArray encodeCapture(const TiledImage &capture,
+                                    const QString &format);
+
+signals:
+    void captureCompleted(QString location, QVariantMap timings);
+
 public slots:
     Q_NOREPLY void graphicCapture(QString path, int delay);
     Q_NOREPLY void fullScreen(QString path, bool toClipboard, int delay);
+    Q_NOREPLY void fullScreenArea(QString path, bool toClipboard, int delay,
+                                  int screen, int x, int y,
+                                  int width, int height);
+    Q_NOREPLY void burstCapture(QString path, int delay, int interval,
+                                int count, int screen, int x, int y,
+                                int width, int height);
+    Q_NOREPLY void archiveCapture(QString archivePath, int keyframeInterval,
+                                  int delay, int screen, int x, int y,
+                                  int width, int height);
+    QByteArray captureData(QString format, int screen, int x, int y,
+                           int width, int height, int &imageWidth,
+                           int &imageHeight);
+    QDBusUnixFileDescriptor captureFileDescriptor(int screen, int x, int y,
+                                                  int width, int height,
+                                                  int &imageWidth,
+                                                  int &imageHeight,
+                                                  int &stride,
+                                                  QString &format);
     Q_NOREPLY void openConfig();
     Q_NOREPLY void trayIconEnabled(bool enabled);
 
@@ -28,8 +28,24 @@ void ResourceExporter::captureToClipboard(const QPixmap &p) {
     ScreenshotSaver().saveToClipboard(p);
 }
 
-void ResourceExporter::captureToFile(const QPixmap &p, const QString &path) {
-    ScreenshotSaver().saveToFilesystem(p, path);
+void ResourceExporter::captureToFile(const QPixmap &p, const QString &path,
+                                     const ScreenshotSaver::SaveCallback &onSaved)
+{
+    ScreenshotSaver().saveToFilesystem(p, path, onSaved);
+}
+
+void ResourceExporter::captureToFile(const QImage &image, const QString &path,
+                                     const int screen)
+{
+    ScreenshotSaver().saveToFilesystem(image, path,
+                                       ScreenshotSaver::SaveCallback(), screen);
+}
+
+void ResourceExporter::captureToArchive(const QImage &image,
+                                        const QString &archivePath,
+                                        const int keyframeInterval)
+{
+    ScreenshotSaver().saveToArchive(image, archivePath, keyframeInterval);
 }
 
 void ResourceExporter::captureToFileUi(const QPixmap &p) {
@@ -18,6 +18,7 @@
 #ifndef RESOURCEEXPORTER_H
 #define RESOURCEEXPORTER_H
 
+#include "src/capture/workers/screenshotsaver.h"
 #include <QPixmap>
 
 class ResourceExporter {
@@ -25,8 +26,14 @@ public:
     ResourceExporter();
 
     void captureToClipboard(const QPixmap &p);
-    void captureToFile(const QPixmap &p, const QString &path);
+    void captureToFile(const QPixmap &p, const QString &path,
+                       const ScreenshotSaver::SaveCallback &onSaved =
+            ScreenshotSaver::SaveCallback());
+    void captureToFile(const QImage &image, const QString &path,
+                       const int screen = -1);
     void captureToFileUi(const QPixmap &p);
+    void captureToArchive(const QImage &image, const QString &archivePath,
+                          const int keyframeInterval);
     void captureToImgur(const QPixmap &p);
 };
 
@@ -45,6 +45,7 @@ QVector<const char *> InfoWindow::m_keys = {
     "CTRL + C",
     "CTRL + S",
     "CTRL + Z",
+    "CTRL + SHIFT + Z",
     QT_TR_NOOP("Right Click"),
     QT_TR_NOOP("Mouse Wheel")
 };
@@ -56,6 +57,7 @@ QVector<const char *> InfoWindow::m_description = {
     QT_TR_NOOP("Copy to clipboard"),
     QT_TR_NOOP("Save selection as a file"),
     QT_TR_NOOP("Undo the last modification"),
+    QT_TR_NOOP("Redo the last undone modification"),
     QT_TR_NOOP("Show color picker"),
     QT_TR_NOOP("Change the tool's thickness")
 };
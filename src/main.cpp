@@ -21,12 +21,21 @@
 #include "src/utils/filenamehandler.h"
 #include "src/utils/confighandler.h"
 #include "src/cli/commandlineparser.h"
+#include "src/capture/workers/tilearchive.h"
+#include "src/capture/tiledimage.h"
+#include "src/utils/pngwriter.h"
+#include "src/utils/imageencoder.h"
+#include "src/utils/sealedimage.h"
 #include <QApplication>
 #include <QTranslator>
 #include <QDBusConnection>
 #include <QDBusMessage>
+#include <QDBusUnixFileDescriptor>
 #include <QTextStream>
 #include <QDir>
+#include <QFileInfo>
+#include <QFile>
+#include <QThread>
 
 int main(int argc, char *argv[]) {
     // required for the button serialization
@@ -69,6 +78,8 @@ int main(int argc, char *argv[]) {
     CommandArgument fullArgument("full", "Capture the entire desktop.");
     CommandArgument guiArgument("gui", "Start a manual capture in GUI mode.");
     CommandArgument configArgument("config", "Configure flameshot.");
+    CommandArgument extractArgument("extract",
+                                    "Extract the frames of a tile archive.");
 
     // Options
     CommandOption pathOption(
@@ -102,6 +113,58 @@ int main(int argc, char *argv[]) {
                 {"k", "contrastcolor"},
                 "Define the contrast UI color",
                 "color-code");
+    CommandOption regionOption(
+                {"r", "region"},
+                "Capture only an area, relative to the screen when one is set",
+                "x,y,w,h");
+    CommandOption screenOption(
+                {"n", "screen"},
+                "Capture only the screen with this index, starting at 0",
+                "index");
+    CommandOption intervalOption(
+                {"i", "interval"},
+                "Time between the captures of a burst, used with --count",
+                "milliseconds");
+    CommandOption countOption(
+                {"count"},
+                "Number of captures of a burst, used with --interval",
+                "number");
+    CommandOption compressionOption(
+                {"compression"},
+                "Set the PNG compression preset: fastest, balanced or smallest",
+                "preset");
+    CommandOption formatOption(
+                {"format"},
+                "Set the format of the saved captures: png, qoi, jpg, webp...",
+                "format");
+    CommandOption qualityOption(
+                {"quality"},
+                "Set the quality of the format, from 0 to 100, -1 for the default",
+                "quality");
+    CommandOption stdoutOption(
+                {"stdout"},
+                "Write the capture to the standard output instead of a file");
+    CommandOption streamFormatOption(
+                {"format"},
+                "Format of the capture written to the standard output: png, "
+                "ppm or raw (32 bit pixels 0xffRRGGBB)",
+                "format");
+    CommandOption optimizeOption(
+                {"optimize"},
+                "Optimize the size of the saved PNG files in the background",
+                "bool");
+    CommandOption archiveOption(
+                {"a", "archive"},
+                "Tile archive where the captures are appended or extracted",
+                "file");
+    CommandOption keyframeOption(
+                {"keyframe"},
+                "Frames between two complete frames of the archive",
+                "number");
+    CommandOption frameOption(
+                {"frame"},
+                "Extract only this frame, starting at 0",
+                "index");
 
     // Add checkers
     auto colorChecker = [&parser](const QString &colorCode) -> bool {
@@ -132,23 +195,96 @@ int main(int argc, char *argv[]) {
     };
     QString booleanErr = "Ivalid value, it must be defined as 'true' or 'false'";
 
+    auto regionChecker = [&parser](const QString &value) -> bool {
+        QStringList values = value.split(',');
+        if (values.size() != 4) {
+            return false;
+        }
+        bool ok = true;
+        for (int i = 0; i < values.size() && ok; ++i) {
+            int n = values.at(i).toInt(&ok);
+            // the width and the height
+            if (i >= 2 && n <= 0) {
+                ok = false;
+            }
+        }
+        return ok;
+    };
+    QString regionErr = "Invalid region, it must be defined as x,y,w,h "
+                        "with a width and a height higher than 0";
+
+    auto screenChecker = [&parser](const QString &value) -> bool {
+        bool ok;
+        int index = value.toInt(&ok);
+        return ok && index >= 0;
+    };
+    QString screenErr = "Invalid screen, it must be a number higher or equal to 0";
+
+    auto positiveChecker = [&parser](const QString &value) -> bool {
+        bool ok;
+        int n = value.toInt(&ok);
+        return ok && n > 0;
+    };
+    QString positiveErr = "Invalid value, it must be a number higher than 0";
+
     contrastColorOption.addChecker(colorChecker, colorErr);
     mainColorOption.addChecker(colorChecker, colorErr);
     delayOption.addChecker(delayChecker, delayErr);
     pathOption.addChecker(pathChecker, pathErr);
     trayOption.addChecker(booleanChecker, booleanErr);
     showHelpOption.addChecker(booleanChecker, booleanErr);
+    optimizeOption.addChecker(booleanChecker, booleanErr);
+    regionOption.addChecker(regionChecker, regionErr);
+    screenOption.addChecker(screenChecker, screenErr);
+    intervalOption.addChecker(positiveChecker, positiveErr);
+    countOption.addChecker(positiveChecker, positiveErr);
+    auto compressionChecker = [&parser](const QString &value) -> bool {
+        return PngWriter::isPresetName(value);
+    };
+    compressionOption.addChecker(compressionChecker, "Invalid preset, it "
+                                 "must be fastest, balanced or smallest");
+    auto formatChecker = [&parser](const QString &value) -> bool {
+        return ImageEncoder::isSupportedFormat(value);
+    };
+    QString formatErr = "Invalid format, the available formats are: "
+            + ImageEncoder::supportedFormats().join(", ");
+    formatOption.addChecker(formatChecker, formatErr);
+    auto qualityChecker = [&parser](const QString &value) -> bool {
+        bool ok;
+        int quality = value.toInt(&ok);
+        return ok && quality >= -1 && quality <= 100;
+    };
+    qualityOption.addChecker(qualityChecker, "Invalid quality, it must be a "
+                             "number from 0 to 100 or -1");
+    auto streamFormatChecker = [&parser](const QString &value) -> bool {
+        return value == "png" || value == "ppm" || value == "raw";
+    };
+    streamFormatOption.addChecker(streamFormatChecker, "Invalid format, it "
+                                  "must be png, ppm or raw");
+    keyframeOption.addChecker(positiveChecker, positiveErr);
+    frameOption.addChecker(screenChecker, "Invalid frame, it must be a "
+                                          "number higher or equal to 0");
 
     // Relationships
     parser.AddArgument(guiArgument);
     parser.AddArgument(fullArgument);
     parser.AddArgument(configArgument);
+    parser.AddArgument(extractArgument);
     auto helpOption = parser.addHelpOption();
     auto versionOption = parser.addVersionOption();
     parser.AddOptions({ pathOption, delayOption }, guiArgument);
-    parser.AddOptions({ pathOption, clipboardOption, delayOption }, fullArgument);
+    parser.AddOptions({ pathOption, clipboardOption, delayOption,
+                        regionOption, screenOption, intervalOption,
+                        countOption, archiveOption, keyframeOption,
+                        stdoutOption, streamFormatOption },
+                      fullArgument);
+    parser.AddOptions({ archiveOption, frameOption, pathOption },
+                      extractArgument);
     parser.AddOptions({ filenameOption, trayOption, showHelpOption,
-                        mainColorOption, contrastColorOption }, configArgument);
+                        mainColorOption, contrastColorOption,
+                        compressionOption, formatOption, qualityOption,
+                        optimizeOption },
+                      configArgument);
     // Parse
     if (!parser.parse(app.arguments()))
         return 0;
@@ -171,21 +307,182 @@ int main(int argc, char *argv[]) {
         QString pathValue = parser.value(pathOption);
         int delay = parser.value(delayOption).toInt();
         bool toClipboard = parser.isSet(clipboardOption);
+        int screen = -1;
+        if (parser.isSet(screenOption)) {
+            screen = parser.value(screenOption).toInt();
+        }
+        QList<int> region = {0, 0, 0, 0};
+        if (parser.isSet(regionOption)) {
+            QStringList values = parser.value(regionOption).split(',');
+            for (int i = 0; i < values.size(); ++i) {
+                region[i] = values.at(i).toInt();
+            }
+        }
+
+        bool burst = parser.isSet(intervalOption) || parser.isSet(countOption);
+        if (burst && !(parser.isSet(intervalOption) && parser.isSet(countOption))) {
+            QTextStream(stderr) << "The options --interval and --count "
+                                   "must be used together.\n";
+            return 0;
+        }
+        bool archive = parser.isSet(archiveOption);
+        if (archive && burst) {
+            QTextStream(stderr) << "The option --archive can't be used "
+                                   "with a burst.\n";
+            return 0;
+        }
+        bool toStdout = parser.isSet(stdoutOption);
+        if (toStdout && (archive || burst)) {
+            QTextStream(stderr) << "The option --stdout can't be used "
+                                   "with an archive or a burst.\n";
+            return 0;
+        }
+        if (toStdout && (parser.isSet(pathOption) || toClipboard)) {
+            QTextStream(stderr) << "The option --stdout can't be used "
+                                   "with --path or --clipboard.\n";
+            return 0;
+        }
+        if (parser.isSet(streamFormatOption) && !toStdout) {
+            QTextStream(stderr) << "The option --format must be used "
+                                   "with --stdout.\n";
+            return 0;
+        }
+
+        if (toStdout) {
+            QString format = parser.isSet(streamFormatOption) ?
+                        parser.value(streamFormatOption) : "png";
+            // the capture is returned by the call, the delay is waited here
+            QThread::msleep(delay);
+            QFile output;
+            output.open(stdout, QIODevice::WriteOnly);
+            // the pixels are mapped from the memory file of the daemon and
+            // encoded here, the capture is copied through the bus if it
+            // isn't supported
+            QDBusMessage m = QDBusMessage::createMethodCall(
+                        "org.dharkael.Flameshot", "/", "",
+                        "captureFileDescriptor");
+            m << screen << region.at(0) << region.at(1)
+              << region.at(2) << region.at(3);
+            QDBusMessage reply = QDBusConnection::sessionBus().call(m);
+            QList<QVariant> values = reply.arguments();
+            if (reply.type() == QDBusMessage::ReplyMessage
+                    && values.size() == 5)
+            {
+                auto fd = qvariant_cast<QDBusUnixFileDescriptor>(
+                            values.at(0));
+                int width = values.at(1).toInt();
+                int height = values.at(2).toInt();
+                int stride = values.at(3).toInt();
+                if (fd.isValid() && format == "raw" && stride == width * 4) {
+                    // the raw pixels don't carry the size
+                    QTextStream(stderr) << width << "x" << height << "\n";
+                    bool ok = SealedImage::writeMapped(
+                                fd.fileDescriptor(),
+                                static_cast<qint64>(stride) * height,
+                                &output);
+                    return ok ? 0 : 1;
+                }
+                QImage image;
+                if (fd.isValid()) {
+                    image = SealedImage::readMapped(
+                                fd.fileDescriptor(), QSize(width, height),
+                                stride);
+                }
+                if (!image.isNull()) {
+                    if (format == "raw") {
+                        QTextStream(stderr) << width << "x" << height << "\n";
+                    }
+                    QByteArray data = FlameshotDBusAdapter::encodeCapture(
+                                TiledImage(image), format);
+                    return output.write(data) == data.size() ? 0 : 1;
+                }
+            }
+            m = QDBusMessage::createMethodCall(
+                        "org.dharkael.Flameshot", "/", "", "captureData");
+            m << format << screen << region.at(0) << region.at(1)
+              << region.at(2) << region.at(3);
+            reply = QDBusConnection::sessionBus().call(m);
+            if (reply.type() == QDBusMessage::ErrorMessage) {
+                QTextStream(stderr) << reply.errorMessage() << "\n";
+                return 1;
+            }
+            values = reply.arguments();
+            QByteArray data = values.value(0).toByteArray();
+            if (data.isEmpty()) {
+                QTextStream(stderr) << "The capture couldn't be taken.\n";
+                return 1;
+            }
+            if (format == "raw") {
+                // the raw pixels don't carry the size
+                QTextStream(stderr) << values.value(1).toInt() << "x"
+                                    << values.value(2).toInt() << "\n";
+            }
+            return output.write(data) == data.size() ? 0 : 1;
+        }
 
         // Send message
-        QDBusMessage m = QDBusMessage::createMethodCall("org.dharkael.Flameshot",
-                                           "/", "", "fullScreen");
-        m << pathValue << toClipboard << delay;
+        QDBusMessage m;
+        if (archive) {
+            // the daemon doesn't share the working directory
+            QString archivePath = QFileInfo(parser.value(archiveOption))
+                    .absoluteFilePath();
+            int keyframeInterval = TileArchive::DEFAULT_KEYFRAME_INTERVAL;
+            if (parser.isSet(keyframeOption)) {
+                keyframeInterval = parser.value(keyframeOption).toInt();
+            }
+            m = QDBusMessage::createMethodCall("org.dharkael.Flameshot",
+                                               "/", "", "archiveCapture");
+            m << archivePath << keyframeInterval << delay << screen;
+        } else if (burst) {
+            int interval = parser.value(intervalOption).toInt();
+            int count = parser.value(countOption).toInt();
+            m = QDBusMessage::createMethodCall("org.dharkael.Flameshot",
+                                               "/", "", "burstCapture");
+            m << pathValue << delay << interval << count << screen;
+        } else {
+            m = QDBusMessage::createMethodCall("org.dharkael.Flameshot",
+                                               "/", "", "fullScreenArea");
+            m << pathValue << toClipboard << delay << screen;
+        }
+        m << region.at(0) << region.at(1) << region.at(2) << region.at(3);
         QDBusConnection::sessionBus().call(m);
     }
+    else if (parser.isSet(extractArgument)) { // EXTRACT
+        if (!parser.isSet(archiveOption)) {
+            QTextStream(stderr) << "The option --archive is required.\n";
+            return 0;
+        }
+        QString archivePath = parser.value(archiveOption);
+        QString dir = parser.isSet(pathOption) ?
+                    parser.value(pathOption) : QDir::currentPath();
+        QString prefix = QDir(dir).filePath(
+                    QFileInfo(archivePath).completeBaseName());
+        TileArchive archive(archivePath);
+        if (parser.isSet(frameOption)) {
+            int frame = parser.value(frameOption).toInt();
+            QString path = archive.extractFrame(frame, prefix);
+            if (path.isEmpty()) {
+                QTextStream(stderr) << archive.errorString() << "\n";
+            } else {
+                QTextStream(stdout) << "Frame saved as " << path << "\n";
+            }
+        } else if (!archive.extractAll(prefix)) {
+            QTextStream(stderr) << archive.errorString() << "\n";
+        }
+    }
     else if (parser.isSet(configArgument)) { // CONFIG
         bool filename = parser.isSet(filenameOption);
         bool tray = parser.isSet(trayOption);
         bool help = parser.isSet(showHelpOption);
         bool mainColor = parser.isSet(mainColorOption);
         bool contrastColor = parser.isSet(contrastColorOption);
-        bool someFlagSet = (filename || tray || help ||
-                            mainColor || contrastColor);
+        bool compression = parser.isSet(compressionOption);
+        bool format = parser.isSet(formatOption);
+        bool quality = parser.isSet(qualityOption);
+        bool optimize = parser.isSet(optimizeOption);
+        bool someFlagSet = (filename || tray || help || mainColor ||
+                            contrastColor || compression || format ||
+                            quality || optimize);
         ConfigHandler config;
         if (filename) {
             QString newFilename(parser.value(filenameOption));
@@ -222,6 +519,20 @@ int main(int argc, char *argv[]) {
             QColor parsedColor(colorCode);
             config.setUIContrastColor(parsedColor);
         }
+        if (compression) {
+            config.setPngCompression(parser.value(compressionOption).toLower());
+        }
+        if (format) {
+            config.setSaveFormat(parser.value(formatOption).toLower());
+        }
+        if (optimize) {
+            config.setOptimizePng(parser.value(optimizeOption) == "true");
+        }
+        // the quality of the selected format
+        if (quality) {
+            config.setFormatQuality(config.saveFormatValue(),
+                                    parser.value(qualityOption).toInt());
+        }
 
         // Open gui when no options
         if (!someFlagSet) {
@@ -107,6 +107,66 @@ void ConfigHandler::setdrawThickness(const int thickness) {
     m_settings.setValue("drawThickness", thickness);
 }
 
+// undoMemoryLimitValue returns the memory in MB available to store the
+// pixels needed to undo the modifications of a capture
+int ConfigHandler::undoMemoryLimitValue() {
+    return m_settings.value("undoMemoryLimit", 256).toInt();
+}
+
+void ConfigHandler::setUndoMemoryLimit(const int megabytes) {
+    m_settings.setValue("undoMemoryLimit", megabytes);
+}
+
+// renderStatisticsValue returns true if the rendering statistics are shown
+// over the capture
+bool ConfigHandler::renderStatisticsValue() {
+    return m_settings.value("showRenderStatistics", false).toBool();
+}
+
+void ConfigHandler::setRenderStatistics(const bool show) {
+    m_settings.setValue("showRenderStatistics", show);
+}
+
+// pngCompressionValue returns the name of the preset of the PNG encoder:
+// fastest, balanced or smallest
+QString ConfigHandler::pngCompressionValue() {
+    return m_settings.value("pngCompression", "balanced").toString();
+}
+
+void ConfigHandler::setPngCompression(const QString &preset) {
+    m_settings.setValue("pngCompression", preset);
+}
+
+// optimizePngValue returns true if the saved PNG files are optimized in
+// the background after being written
+bool ConfigHandler::optimizePngValue() {
+    return m_settings.value("optimizePng", false).toBool();
+}
+
+void ConfigHandler::setOptimizePng(const bool optimize) {
+    m_settings.setValue("optimizePng", optimize);
+}
+
+// saveFormatValue returns the format of the saved captures, it's also the
+// extension of their files
+QString ConfigHandler::saveFormatValue() {
+    return m_settings.value("saveFormat", "png").toString();
+}
+
+void ConfigHandler::setSaveFormat(const QString &format) {
+    m_settings.setValue("saveFormat", format);
+}
+
+// formatQualityValue returns the quality from 0 to 100 used by a lossy
+// format, -1 is the default of its image plugin
+int ConfigHandler::formatQualityValue(const QString &format) {
+    return m_settings.value("formatQuality/" + format, -1).toInt();
+}
+
+void ConfigHandler::setFormatQuality(const QString &format, const int quality) {
+    m_settings.setValue("formatQuality/" + format, quality);
+}
+
 bool ConfigHandler::initiatedIsSet() {
     return m_settings.value("initiated").toBool();
 }
@@ -57,6 +57,24 @@ public:
     int drawThicknessValue();
     void setdrawThickness(const int);
 
+    int undoMemoryLimitValue();
+    void setUndoMemoryLimit(const int);
+
+    bool renderStatisticsValue();
+    void setRenderStatistics(const bool);
+
+    QString pngCompressionValue();
+    void setPngCompression(const QString &);
+
+    bool optimizePngValue();
+    void setOptimizePng(const bool);
+
+    QString saveFormatValue();
+    void setSaveFormat(const QString &);
+
+    int formatQualityValue(const QString &format);
+    void setFormatQuality(const QString &format, const int);
+
     bool initiatedIsSet();
     void setInitiated();
     void setNotInitiated();
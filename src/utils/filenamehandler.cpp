@@ -18,88 +18,125 @@
 #include "filenamehandler.h"
 #include "src/utils/confighandler.h"
 #include <ctime>
-#include <locale>
 #include <QStandardPaths>
 #include <QDir>
+#include <QAtomicInt>
+#include <QSize>
+#include <QThread>
+#include <QCoreApplication>
+
+namespace {
+
+// number of the last saved capture since the start of the program
+QAtomicInt captureSequence(0);
+
+// the configured pattern, compiled again only after a change of the
+// config. It isn't locked, the names are only generated in the main thread.
+FileNamePattern configuredPattern;
+bool configuredPatternValid = false;
+
+inline void assertMainThread() {
+    Q_ASSERT_X(QThread::currentThread() == qApp->thread(), "FileNameHandler",
+               "the configured pattern is only used in the main thread");
+}
+
+} // unnamed namespace
 
 FileNameHandler::FileNameHandler(QObject *parent) : QObject(parent) {
-    std::locale::global(std::locale(""));
+
 }
 
+// setCaptureInfo sets the size and the screen of the capture being named,
+// used by the %{w}, %{h} and %{screen} tokens of the pattern
+void FileNameHandler::setCaptureInfo(const QSize &size, const int screen) {
+    m_context.width = size.width();
+    m_context.height = size.height();
+    m_context.screen = screen;
+}
+
+// parsedPattern expands the configured pattern, the config is only read
+// when the pattern has been invalidated
 QString FileNameHandler::parsedPattern() {
-    return parseFilename(ConfigHandler().filenamePatternValue());
+    assertMainThread();
+    if (!configuredPatternValid) {
+        configuredPattern = FileNamePattern(
+                    ConfigHandler().filenamePatternValue());
+        configuredPatternValid = true;
+    }
+    return expand(configuredPattern);
 }
 
-QString FileNameHandler::parseFilename(const QString &name) {
-    QString res;
-    if (name.isEmpty()) {
-        res = tr("screenshot");
-    } else {
-        std::time_t t = std::time(NULL);
-
-        char *tempData = QStringTocharArr(name);
-        char data[MAX_CHARACTERS] = {0};
-        std::strftime(data, sizeof(data),
-                      tempData, std::localtime(&t));
-        res = QString::fromLocal8Bit(data, strlen(data));
-        free(tempData);
+// expand returns the name given by the pattern to the capture at the
+// current time
+QString FileNameHandler::expand(const FileNamePattern &pattern) {
+    if (pattern.pattern().isEmpty()) {
+        return tr("screenshot");
     }
-    // add the parsed pattern in a correct format for the filesystem
-    res = res.replace("/", "⁄");
-    return res;
+    std::time_t t = std::time(NULL);
+    std::tm time;
+    localtime_r(&t, &time);
+    pattern.expand(m_context, time, m_filename);
+    return m_filename;
+}
+
+// invalidatePattern makes the next name read the pattern from the config,
+// it's called when the config changes
+void FileNameHandler::invalidatePattern() {
+    assertMainThread();
+    configuredPatternValid = false;
 }
 
-QString FileNameHandler::generateAbsolutePath(const QString &path)
+QString FileNameHandler::generateAbsolutePath(const QString &path,
+                                              const QString &suffix,
+                                              const FileNameIndex::Mode mode)
 {
     QString directory = path;
+    updateSequence(mode);
     QString filename = parsedPattern();
-    fixPath(directory, filename);
+    fixPath(directory, filename, suffix, mode);
     return directory + filename;
 }
 // path a images si no existe, add numeration
 void FileNameHandler::setPattern(const QString &pattern) {
     ConfigHandler().setFilenamePattern(pattern);
+    invalidatePattern();
 }
 
-QString FileNameHandler::absoluteSavePath(QString &directory, QString &filename) {
+QString FileNameHandler::absoluteSavePath(QString &directory, QString &filename,
+                                          const QString &suffix,
+                                          const FileNameIndex::Mode mode)
+{
     ConfigHandler config;
     directory = config.savePathValue();
     if (directory.isEmpty() || !QDir(directory).exists() || !QFileInfo(directory).isWritable()) {
         directory = QStandardPaths::writableLocation(QStandardPaths::PicturesLocation);
     }
+    updateSequence(mode);
     filename = parsedPattern();
-    fixPath(directory, filename);
+    fixPath(directory, filename, suffix, mode);
     return directory + filename;
 }
 
-QString FileNameHandler::charArrToQString(const char *c) {
-    return QString::fromLocal8Bit(c, MAX_CHARACTERS);
-}
-
-char * FileNameHandler::QStringTocharArr(const QString &s) {
-    QByteArray ba = s.toLocal8Bit();
-    return const_cast<char *>(strdup(ba.constData()));
+// updateSequence sets the number of the capture for the %{seq} token, a
+// proposed name doesn't consume it
+void FileNameHandler::updateSequence(const FileNameIndex::Mode mode) {
+    if (mode == FileNameIndex::PROPOSE) {
+        m_context.sequence = captureSequence.load() + 1;
+    } else {
+        m_context.sequence = captureSequence.fetchAndAddOrdered(1) + 1;
+    }
 }
 
-void FileNameHandler::fixPath(QString &directory, QString &filename) {
+// fixPath adds a number to the filename if a file with the same name and
+// suffix exists in the directory, see FileNameIndex
+void FileNameHandler::fixPath(QString &directory, QString &filename,
+                              const QString &suffix,
+                              const FileNameIndex::Mode mode)
+{
     // add '/' at the end of the directory
     if (!directory.endsWith("/")) {
         directory += "/";
     }
-    // add numeration in case of repeated filename in the directory
-    // find unused name adding _n where n is a number
-    QFileInfo checkFile(directory + filename + ".png");
-    if (checkFile.exists()) {
-        filename += "_";
-        int i = 1;
-        while (true) {
-            checkFile.setFile(
-                        directory + filename + QString::number(i) + ".png");
-            if (!checkFile.exists()) {
-                filename += QString::number(i);
-                break;
-            }
-            ++i;
-        }
-    }
+    filename = FileNameIndex::getInstance()->availableName(
+                directory, filename, suffix, mode);
 }
@@ -18,8 +18,12 @@
 #ifndef FILENAMEHANDLER_H
 #define FILENAMEHANDLER_H
 
+#include "src/utils/filenameindex.h"
+#include "src/utils/filenamepattern.h"
 #include <QObject>
 
+class QSize;
+
 
 class FileNameHandler : public QObject
 {
@@ -27,22 +31,33 @@ class FileNameHandler : public QObject
 public:
     explicit FileNameHandler(QObject *parent = nullptr);
 
+    void setCaptureInfo(const QSize &size, const int screen = -1);
+
     QString parsedPattern();
-    QString parseFilename(const QString &name);
-    QString generateAbsolutePath(const QString &path);
-    QString absoluteSavePath(QString &directory, QString &filename);
+    QString expand(const FileNamePattern &pattern);
+    QString generateAbsolutePath(const QString &path,
+                                 const QString &suffix = "png",
+                                 const FileNameIndex::Mode mode =
+            FileNameIndex::RESERVE);
+    QString absoluteSavePath(QString &directory, QString &filename,
+                             const QString &suffix = "png",
+                             const FileNameIndex::Mode mode =
+            FileNameIndex::PROPOSE);
 
-    static const int MAX_CHARACTERS = 70;
+    static void invalidatePattern();
 
 public slots:
     void setPattern(const QString &pattern);
 
 private:
-    //using charArr = char[MAX_CHARACTERS];
-    QString charArrToQString(const char *c);
-    char * QStringTocharArr(const QString &s);
+    FileNamePattern::Context m_context;
+    // the names are expanded in it, its capacity is only reused by the
+    // handlers which name several captures
+    QString m_filename;
 
-    void fixPath(QString &directory, QString &filename);
+    void updateSequence(const FileNameIndex::Mode mode);
+    void fixPath(QString &directory, QString &filename,
+                 const QString &suffix, const FileNameIndex::Mode mode);
 
 };
 
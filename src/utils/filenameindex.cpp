@@ -0,0 +1,273 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "filenameindex.h"
+#include <QtConcurrent>
+#include <QFutureWatcher>
+#include <QFileSystemWatcher>
+#include <QSocketNotifier>
+#include <QTimer>
+#include <QFileInfo>
+#include <QFile>
+#include <QDir>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef Q_OS_LINUX
+#include <sys/inotify.h>
+#endif
+
+// FileNameIndex finds a free name for a capture without probing every
+// numbered name of a directory. The highest number of every name is read
+// once per directory and then updated with the allocated names, so a
+// lookup costs the same whatever the size of the directory. On Linux the
+// names added to the directory, by Flameshot or by other programs, are
+// read from inotify and added to the index one by one. Elsewhere the
+// directory is scanned again in the background, at most once every
+// SCAN_DELAY. An unexpected existing file only makes the lookup try the
+// next number.
+
+namespace {
+
+const int SCAN_DELAY = 1000;
+
+// the key of a name and its extension in the index of a directory
+inline QString indexKey(const QString &filename, const QString &suffix) {
+    return filename + QLatin1Char('/') + suffix;
+}
+
+void addToIndex(QHash<QString, int> &index, const QString &key,
+                const int number)
+{
+    auto it = index.find(key);
+    if (it == index.end()) {
+        index.insert(key, number);
+    } else if (*it < number) {
+        *it = number;
+    }
+}
+
+// addFileToIndex adds the number of a file of the directory. A numbered
+// name is also indexed as a name without number, it can be the result of
+// the pattern.
+void addFileToIndex(QHash<QString, int> &index, const QString &file) {
+    int dot = file.lastIndexOf(QLatin1Char('.'));
+    if (dot <= 0) {
+        return;
+    }
+    const QString suffix = file.mid(dot + 1);
+    const QString stem = file.left(dot);
+    addToIndex(index, indexKey(stem, suffix), 0);
+    int underscore = stem.lastIndexOf(QLatin1Char('_'));
+    if (underscore > 0 && underscore < stem.size() - 1) {
+        bool ok;
+        int number = stem.mid(underscore + 1).toInt(&ok);
+        if (ok && number > 0) {
+            addToIndex(index, indexKey(stem.left(underscore), suffix),
+                       number);
+        }
+    }
+}
+
+} // unnamed namespace
+
+FileNameIndex::FileNameIndex(QObject *parent) : QObject(parent),
+    m_inotifyFd(-1), m_notifier(nullptr), m_watcher(nullptr)
+{
+    m_scanTimer = new QTimer(this);
+    m_scanTimer->setSingleShot(true);
+    m_scanTimer->setInterval(SCAN_DELAY);
+    connect(m_scanTimer, &QTimer::timeout,
+            this, &FileNameIndex::scanChangedDirectories);
+#ifdef Q_OS_LINUX
+    m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotifyFd >= 0) {
+        m_notifier = new QSocketNotifier(m_inotifyFd, QSocketNotifier::Read,
+                                         this);
+        connect(m_notifier, &QSocketNotifier::activated,
+                this, &FileNameIndex::readNotifications);
+        return;
+    }
+#endif
+    m_watcher = new QFileSystemWatcher(this);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged,
+            this, &FileNameIndex::handleDirectoryChange);
+}
+
+FileNameIndex::~FileNameIndex() {
+    if (m_inotifyFd >= 0) {
+        close(m_inotifyFd);
+    }
+}
+
+FileNameIndex *FileNameIndex::getInstance() {
+    static FileNameIndex index;
+    return &index;
+}
+
+// availableName returns a filename which isn't used in the directory with
+// the suffix, adding _n where n is a number when the filename is in use.
+// The directory must end with '/'.
+QString FileNameIndex::availableName(const QString &directory,
+                                     const QString &filename,
+                                     const QString &suffix,
+                                     const Mode mode)
+{
+    auto dir = m_directories.find(directory);
+    if (dir == m_directories.end()) {
+        dir = m_directories.insert(directory, scanDirectory(directory));
+        watchDirectory(directory);
+    }
+    const QString key = indexKey(filename, suffix);
+    int number = dir->value(key, -1) + 1;
+    QString name;
+    while (true) {
+        name = number == 0 ? filename
+                           : filename + "_" + QString::number(number);
+        QString path = directory + name + "." + suffix;
+        if (mode == CREATE) {
+            // O_EXCL makes the creation fail if another process took it
+            int fd = open(QFile::encodeName(path).constData(),
+                          O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+            if (fd >= 0) {
+                close(fd);
+                break;
+            } else if (errno != EEXIST) {
+                // the error is reported when the capture is written
+                break;
+            }
+        } else if (!QFileInfo::exists(path)) {
+            break;
+        }
+        ++number;
+    }
+    if (mode != PROPOSE) {
+        addToIndex(*dir, key, number);
+    }
+    return name;
+}
+
+void FileNameIndex::watchDirectory(const QString &directory) {
+#ifdef Q_OS_LINUX
+    if (m_inotifyFd >= 0) {
+        int wd = inotify_add_watch(m_inotifyFd,
+                                   QFile::encodeName(directory).constData(),
+                                   IN_CREATE | IN_MOVED_TO | IN_ONLYDIR);
+        if (wd >= 0) {
+            m_watches.insert(wd, directory);
+        }
+        return;
+    }
+#endif
+    m_watcher->addPath(directory);
+}
+
+// readNotifications adds the names created in the watched directories to
+// their index, the removed names are ignored since the numbers below the
+// highest one aren't reused
+void FileNameIndex::readNotifications() {
+#ifdef Q_OS_LINUX
+    alignas(inotify_event) char buffer[4096];
+    ssize_t length;
+    while ((length = read(m_inotifyFd, buffer, sizeof(buffer))) > 0) {
+        const char *p = buffer;
+        while (p < buffer + length) {
+            auto event = reinterpret_cast<const inotify_event *>(p);
+            p += sizeof(inotify_event) + event->len;
+            if (event->mask & IN_Q_OVERFLOW) {
+                // the names were lost
+                for (const QString &directory: m_watches) {
+                    handleDirectoryChange(directory);
+                }
+            } else if (event->mask & IN_IGNORED) {
+                // the directory was removed, it's read again when it's used
+                m_directories.remove(m_watches.take(event->wd));
+            } else if (event->len > 0 && !(event->mask & IN_ISDIR)) {
+                auto dir = m_directories.find(m_watches.value(event->wd));
+                if (dir != m_directories.end()) {
+                    addFileToIndex(*dir, QFile::decodeName(event->name));
+                }
+            }
+        }
+    }
+#endif
+}
+
+// handleDirectoryChange scans the directory again after SCAN_DELAY, the
+// changes made meanwhile are merged in the same scan
+void FileNameIndex::handleDirectoryChange(const QString &directory) {
+    if (!m_directories.contains(directory)) {
+        return;
+    }
+    m_changedDirectories.insert(directory);
+    if (!m_scanTimer->isActive()) {
+        m_scanTimer->start();
+    }
+}
+
+void FileNameIndex::scanChangedDirectories() {
+    for (const QString &directory: m_changedDirectories) {
+        if (m_scanning.contains(directory)) {
+            m_pendingScans.insert(directory);
+        } else {
+            scanInBackground(directory);
+        }
+    }
+    m_changedDirectories.clear();
+}
+
+// scanDirectory reads the highest number of every name of the directory
+FileNameIndex::SuffixIndex FileNameIndex::scanDirectory(const QString &directory) {
+    SuffixIndex index;
+    const QStringList files = QDir(directory).entryList(
+                QDir::Files | QDir::Hidden, QDir::Unsorted);
+    for (const QString &file: files) {
+        addFileToIndex(index, file);
+    }
+    return index;
+}
+
+void FileNameIndex::scanInBackground(const QString &directory) {
+    m_scanning.insert(directory);
+    auto watcher = new QFutureWatcher<SuffixIndex>(this);
+    connect(watcher, &QFutureWatcher<SuffixIndex>::finished,
+            this, [this, watcher, directory]()
+    {
+        mergeIndex(directory, watcher->result());
+        watcher->deleteLater();
+        m_scanning.remove(directory);
+        if (m_pendingScans.remove(directory)) {
+            scanInBackground(directory);
+        }
+    });
+    watcher->setFuture(QtConcurrent::run(&FileNameIndex::scanDirectory,
+                                         directory));
+}
+
+// mergeIndex keeps the highest numbers, the names allocated during the
+// scan are not lost
+void FileNameIndex::mergeIndex(const QString &directory,
+                               const SuffixIndex &index)
+{
+    auto dir = m_directories.find(directory);
+    if (dir == m_directories.end()) {
+        return;
+    }
+    for (auto it = index.constBegin(); it != index.constEnd(); ++it) {
+        addToIndex(*dir, it.key(), it.value());
+    }
+}
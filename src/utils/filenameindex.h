@@ -0,0 +1,82 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FILENAMEINDEX_H
+#define FILENAMEINDEX_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+
+class QFileSystemWatcher;
+class QSocketNotifier;
+class QTimer;
+
+class FileNameIndex : public QObject
+{
+    Q_OBJECT
+public:
+    static FileNameIndex* getInstance();
+
+    FileNameIndex(const FileNameIndex&) = delete;
+    void operator =(const FileNameIndex&) = delete;
+
+    enum Mode {
+        // returns a free name
+        PROPOSE,
+        // the name isn't returned again
+        RESERVE,
+        // the file is also created, atomically
+        CREATE,
+    };
+
+    QString availableName(const QString &directory, const QString &filename,
+                          const QString &suffix, const Mode mode);
+
+private slots:
+    void readNotifications();
+    void handleDirectoryChange(const QString &directory);
+    void scanChangedDirectories();
+
+private:
+    explicit FileNameIndex(QObject *parent = nullptr);
+    ~FileNameIndex();
+
+    // highest number used by every name and suffix of a directory, 0 when
+    // only the name without number is used
+    using SuffixIndex = QHash<QString, int>;
+
+    QHash<QString, SuffixIndex> m_directories;
+    // inotify reports the names added to the directories on Linux, the
+    // directories are scanned again when they change otherwise
+    int m_inotifyFd;
+    QSocketNotifier *m_notifier;
+    QHash<int, QString> m_watches;
+    QFileSystemWatcher *m_watcher;
+    // the changes are merged in a scan after SCAN_DELAY
+    QTimer *m_scanTimer;
+    QSet<QString> m_changedDirectories;
+    QSet<QString> m_scanning;
+    QSet<QString> m_pendingScans;
+
+    void watchDirectory(const QString &directory);
+    static SuffixIndex scanDirectory(const QString &directory);
+    void scanInBackground(const QString &directory);
+    void mergeIndex(const QString &directory, const SuffixIndex &index);
+};
+
+#endif // FILENAMEINDEX_H
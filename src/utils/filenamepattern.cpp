@@ -0,0 +1,276 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "filenamepattern.h"
+#include <QFile>
+#include <cwchar>
+#include <iterator>
+#include <locale>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+// FileNamePattern compiles a filename pattern once into a list of tokens:
+// literal text, strftime conversions and the values of the capture:
+// %{seq} the sequence number, %{w} and %{h} its size and %{screen} the
+// index of its screen. The expansion appends the tokens to a string
+// which keeps its capacity, so it doesn't allocate once it has grown.
+
+namespace {
+
+const QString SEQUENCE_TOKEN = "%{seq}";
+const QString WIDTH_TOKEN = "%{w}";
+const QString HEIGHT_TOKEN = "%{h}";
+const QString SCREEN_TOKEN = "%{screen}";
+
+// appendNumber appends the digits of a number without a temporary string
+void appendNumber(QString &result, const int number) {
+    if (number < 0) {
+        return;
+    }
+    char digits[12];
+    int size = 0;
+    int n = number;
+    do {
+        digits[size++] = '0' + n % 10;
+        n /= 10;
+    } while (n > 0);
+    while (size > 0) {
+        result.append(QLatin1Char(digits[--size]));
+    }
+}
+
+// appendWide appends a wide character, in UTF-32 in Linux
+void appendWide(QString &result, const wchar_t character) {
+    uint c = static_cast<uint>(character);
+    if (QChar::requiresSurrogates(c)) {
+        result.append(QChar(QChar::highSurrogate(c)));
+        result.append(QChar(QChar::lowSurrogate(c)));
+    } else {
+        result.append(QChar(c));
+    }
+}
+
+// StringAppender is a stream buffer which appends what is written to a
+// string, without an intermediate buffer
+class StringAppender : public std::wstreambuf {
+public:
+    explicit StringAppender(QString &result) : m_result(result) {}
+
+protected:
+    int_type overflow(int_type c) override {
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            appendWide(m_result, traits_type::to_char_type(c));
+        }
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize xsputn(const char_type *text,
+                           std::streamsize size) override
+    {
+        for (std::streamsize i = 0; i < size; ++i) {
+            appendWide(m_result, text[i]);
+        }
+        return size;
+    }
+
+private:
+    QString &m_result;
+};
+
+// TimeFormatter writes the strftime conversions with the locale of the
+// environment, which names the months and the days. The global locale of
+// the program isn't changed, the locale is only imbued in the stream
+// whose format flags are used.
+class TimeFormatter {
+public:
+    TimeFormatter() :
+        m_locale(environmentLocale()),
+        m_facet(std::use_facet<std::time_put<wchar_t>>(m_locale))
+    {
+        m_stream.imbue(m_locale);
+    }
+
+    // format only reads the stream, it can be called from several threads
+    void format(const std::tm &time, const wchar_t *format,
+                QString &result) const
+    {
+        StringAppender appender(result);
+        m_facet.put(std::ostreambuf_iterator<wchar_t>(&appender), m_stream,
+                    L' ', &time, format, format + std::wcslen(format));
+    }
+
+private:
+    std::locale m_locale;
+    const std::time_put<wchar_t> &m_facet;
+    mutable std::wostringstream m_stream;
+
+    // environmentLocale falls back to the "C" locale when the one of the
+    // environment isn't installed
+    static std::locale environmentLocale() {
+        try {
+            return std::locale("");
+        } catch (const std::runtime_error &) {
+            return std::locale::classic();
+        }
+    }
+};
+
+// timeFormatter creates the formatter once, it isn't destroyed so the names
+// can be expanded until the exit
+const TimeFormatter &timeFormatter() {
+    static std::once_flag created;
+    static TimeFormatter *formatter = nullptr;
+    std::call_once(created, []() {
+        formatter = new TimeFormatter();
+    });
+    return *formatter;
+}
+
+} // unnamed namespace
+
+FileNamePattern::FileNamePattern() {
+
+}
+
+FileNamePattern::FileNamePattern(const QString &pattern) : m_pattern(pattern) {
+    compile();
+}
+
+QString FileNamePattern::pattern() const {
+    return m_pattern;
+}
+
+// expand writes the name in the result, its capacity is reused. The '/'
+// are replaced because they can't be part of a filename.
+void FileNamePattern::expand(const Context &context, const std::tm &time,
+                             QString &result) const
+{
+    result.resize(0);
+    const TimeFormatter &formatter = timeFormatter();
+    for (const Token &token: m_tokens) {
+        switch (token.type) {
+        case LITERAL:
+            result.append(token.literal);
+            break;
+        case TIME:
+            formatter.format(time, token.format, result);
+            break;
+        case SEQUENCE:
+            appendNumber(result, context.sequence);
+            break;
+        case WIDTH:
+            appendNumber(result, context.width);
+            break;
+        case HEIGHT:
+            appendNumber(result, context.height);
+            break;
+        case SCREEN:
+            appendNumber(result, context.screen);
+            break;
+        }
+    }
+    QChar *data = result.data();
+    for (int i = 0; i < result.size(); ++i) {
+        if (data[i] == QLatin1Char('/')) {
+            data[i] = QChar(0x2044); // fraction slash
+        }
+    }
+    // a character takes 3 bytes at most, only the long names are encoded
+    // to be measured
+    if (result.size() * 3 > MAX_LENGTH) {
+        int excess = QFile::encodeName(result).size() - MAX_LENGTH;
+        while (excess > 0) {
+            result.chop((excess + 2) / 3);
+            // a character out of the BMP isn't split
+            if (!result.isEmpty()
+                    && result.at(result.size() - 1).isHighSurrogate())
+            {
+                result.chop(1);
+            }
+            excess = QFile::encodeName(result).size() - MAX_LENGTH;
+        }
+    }
+}
+
+void FileNamePattern::compile() {
+    m_tokens.clear();
+    Token literal;
+    literal.type = LITERAL;
+    auto addLiteral = [&]() {
+        if (!literal.literal.isEmpty()) {
+            m_tokens << literal;
+            literal.literal.clear();
+        }
+    };
+    auto addToken = [&](const TokenType type) {
+        addLiteral();
+        Token token;
+        token.type = type;
+        m_tokens << token;
+    };
+
+    const int size = m_pattern.size();
+    int i = 0;
+    while (i < size) {
+        QChar c = m_pattern.at(i);
+        if (c != QLatin1Char('%') || i + 1 == size) {
+            literal.literal.append(c);
+            ++i;
+            continue;
+        }
+        QChar next = m_pattern.at(i + 1);
+        if (next == QLatin1Char('%')) {
+            literal.literal.append(next);
+            i += 2;
+        } else if (next == QLatin1Char('{')) {
+            QStringRef rest = m_pattern.midRef(i);
+            if (rest.startsWith(SEQUENCE_TOKEN)) {
+                addToken(SEQUENCE);
+                i += SEQUENCE_TOKEN.size();
+            } else if (rest.startsWith(WIDTH_TOKEN)) {
+                addToken(WIDTH);
+                i += WIDTH_TOKEN.size();
+            } else if (rest.startsWith(HEIGHT_TOKEN)) {
+                addToken(HEIGHT);
+                i += HEIGHT_TOKEN.size();
+            } else if (rest.startsWith(SCREEN_TOKEN)) {
+                addToken(SCREEN);
+                i += SCREEN_TOKEN.size();
+            } else {
+                literal.literal.append(c);
+                ++i;
+            }
+        } else {
+            // strftime conversion, with its E or O modifier
+            int length = 2;
+            if ((next == QLatin1Char('E') || next == QLatin1Char('O'))
+                    && i + 2 < size)
+            {
+                length = 3;
+            }
+            addToken(TIME);
+            Token &token = m_tokens.last();
+            for (int j = 0; j < length; ++j) {
+                token.format[j] = m_pattern.at(i + j).unicode();
+            }
+            token.format[length] = L'\0';
+            i += length;
+        }
+    }
+    addLiteral();
+}
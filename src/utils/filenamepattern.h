@@ -0,0 +1,73 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FILENAMEPATTERN_H
+#define FILENAMEPATTERN_H
+
+#include <QString>
+#include <QVector>
+#include <ctime>
+
+class FileNamePattern
+{
+public:
+    // values of the capture, the negative ones are left empty
+    struct Context {
+        Context() : sequence(-1), width(-1), height(-1), screen(-1) {}
+
+        int sequence;
+        int width;
+        int height;
+        int screen;
+    };
+
+    FileNamePattern();
+    explicit FileNamePattern(const QString &pattern);
+
+    QString pattern() const;
+    void expand(const Context &context, const std::tm &time,
+                QString &result) const;
+
+    // longest expanded name in bytes, in the encoding of the filenames.
+    // The filesystems limit a name to 255 bytes, the rest is left for the
+    // number and the suffix added to it.
+    static const int MAX_LENGTH = 200;
+
+private:
+    enum TokenType {
+        LITERAL,
+        TIME,
+        SEQUENCE,
+        WIDTH,
+        HEIGHT,
+        SCREEN,
+    };
+
+    struct Token {
+        TokenType type;
+        QString literal;
+        // strftime conversion like %Y or %Ey
+        wchar_t format[4];
+    };
+
+    QString m_pattern;
+    QVector<Token> m_tokens;
+
+    void compile();
+};
+
+#endif // FILENAMEPATTERN_H
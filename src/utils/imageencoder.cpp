@@ -0,0 +1,82 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "imageencoder.h"
+#include "src/utils/confighandler.h"
+#include "src/utils/qoiwriter.h"
+#include <QImageWriter>
+#include <QFileInfo>
+#include <QFile>
+
+// ImageEncoder writes the captures in the format of the extension of the
+// file, the configured format is used to name the new files. PNG and QOI
+// are encoded in-tree, the other formats by the image plugins of Qt with
+// the quality configured for each one. The configuration is read when the
+// encoder is created so it can write from any thread.
+
+ImageEncoder::ImageEncoder() {
+    ConfigHandler config;
+    m_format = config.saveFormatValue();
+    if (!isSupportedFormat(m_format)) {
+        m_format = "png";
+    }
+    m_pngPreset = PngWriter::presetFromName(config.pngCompressionValue());
+    for (const QString &format: supportedFormats()) {
+        m_qualities.insert(format, config.formatQualityValue(format));
+    }
+}
+
+// format returns the configured format, which is the extension of the
+// new files
+QString ImageEncoder::format() const {
+    return m_format;
+}
+
+bool ImageEncoder::write(const QImage &image, const QString &path) const {
+    QString format = QFileInfo(path).suffix().toLower();
+    if (format.isEmpty()) {
+        format = m_format;
+    }
+    if (format == "png") {
+        return PngWriter(m_pngPreset).write(image, path);
+    } else if (format == "qoi") {
+        QByteArray data = QoiWriter().encode(image);
+        QFile file(path);
+        return !data.isEmpty() && file.open(QIODevice::WriteOnly)
+                && file.write(data) == data.size();
+    }
+    QImageWriter writer(path, format.toLatin1());
+    writer.setQuality(m_qualities.value(format, -1));
+    return writer.write(image);
+}
+
+// supportedFormats returns the formats which can be written, the in-tree
+// ones and the ones of the available image plugins
+QStringList ImageEncoder::supportedFormats() {
+    QStringList formats = {"png", "qoi"};
+    for (const QByteArray &format: QImageWriter::supportedImageFormats()) {
+        QString name = QString::fromLatin1(format).toLower();
+        if (!formats.contains(name)) {
+            formats << name;
+        }
+    }
+    return formats;
+}
+
+bool ImageEncoder::isSupportedFormat(const QString &format) {
+    return supportedFormats().contains(format.toLower());
+}
@@ -0,0 +1,45 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef IMAGEENCODER_H
+#define IMAGEENCODER_H
+
+#include "src/utils/pngwriter.h"
+#include <QHash>
+#include <QStringList>
+
+class QImage;
+
+class ImageEncoder
+{
+public:
+    explicit ImageEncoder();
+
+    QString format() const;
+
+    bool write(const QImage &image, const QString &path) const;
+
+    static QStringList supportedFormats();
+    static bool isSupportedFormat(const QString &format);
+
+private:
+    QString m_format;
+    PngWriter::Preset m_pngPreset;
+    QHash<QString, int> m_qualities;
+};
+
+#endif // IMAGEENCODER_H
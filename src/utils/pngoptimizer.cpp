@@ -0,0 +1,106 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "pngoptimizer.h"
+#include "src/utils/pngwriter.h"
+#include <QImage>
+#include <QBuffer>
+#include <QHash>
+#include <QVector>
+
+// PngOptimizer finds the smallest lossless PNG of an image. The alpha
+// channel is dropped when every pixel is opaque and an image with at most
+// 256 colors, common in the screenshots of flat user interfaces, is stored
+// with a palette. The image is then encoded with a few filter heuristics
+// at the highest compression level and the smallest result is kept.
+
+PngOptimizer::PngOptimizer() {
+
+}
+
+QByteArray PngOptimizer::optimize(const QImage &image) {
+    QImage reduced = reducedImage(image);
+    QVector<PngWriter::Filter> filters;
+    if (reduced.format() == QImage::Format_Indexed8) {
+        // the palette indexes rarely benefit from the filters
+        filters << PngWriter::FILTER_NONE << PngWriter::FILTER_ADAPTIVE;
+    } else {
+        filters << PngWriter::FILTER_NONE << PngWriter::FILTER_UP
+                << PngWriter::FILTER_ADAPTIVE;
+    }
+    QByteArray best;
+    for (const PngWriter::Filter filter: filters) {
+        QByteArray data;
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        PngWriter writer(PngWriter::SMALLEST);
+        writer.setFilter(filter);
+        if (writer.write(reduced, &buffer)
+                && (best.isEmpty() || data.size() < best.size()))
+        {
+            best = data;
+        }
+    }
+    return best;
+}
+
+// reducedImage returns the image without the alpha channel if it's opaque
+// and with a palette if it has few colors
+QImage PngOptimizer::reducedImage(const QImage &image) {
+    QImage argb = image.convertToFormat(QImage::Format_ARGB32);
+    bool opaque = true;
+    QHash<QRgb, int> colors;
+    QVector<QRgb> palette;
+    for (int y = 0; y < argb.height(); ++y) {
+        const QRgb *line = reinterpret_cast<const QRgb *>(argb.constScanLine(y));
+        for (int x = 0; x < argb.width(); ++x) {
+            opaque &= qAlpha(line[x]) == 255;
+            if (x > 0 && line[x] == line[x - 1]) {
+                continue;
+            }
+            if (palette.size() <= MAX_PALETTE_COLORS
+                    && !colors.contains(line[x]))
+            {
+                colors.insert(line[x], palette.size());
+                palette << line[x];
+            }
+        }
+    }
+    if (palette.size() > MAX_PALETTE_COLORS) {
+        return argb.convertToFormat(opaque ?
+                    QImage::Format_RGB32 : QImage::Format_ARGB32);
+    }
+    QImage indexed(argb.size(), QImage::Format_Indexed8);
+    indexed.setColorTable(palette);
+    indexed.setDotsPerMeterX(image.dotsPerMeterX());
+    indexed.setDotsPerMeterY(image.dotsPerMeterY());
+    for (int y = 0; y < argb.height(); ++y) {
+        const QRgb *line = reinterpret_cast<const QRgb *>(argb.constScanLine(y));
+        uchar *out = indexed.scanLine(y);
+        QRgb last = line[0];
+        int lastIndex = colors.value(last);
+        for (int x = 0; x < argb.width(); ++x) {
+            // the runs of the same color are common, avoid the lookups
+            if (line[x] != last) {
+                last = line[x];
+                lastIndex = colors.value(last);
+            }
+            out[x] = lastIndex;
+        }
+    }
+    return indexed;
+}
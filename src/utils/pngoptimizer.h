@@ -0,0 +1,38 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PNGOPTIMIZER_H
+#define PNGOPTIMIZER_H
+
+#include <QByteArray>
+
+class QImage;
+
+class PngOptimizer
+{
+public:
+    PngOptimizer();
+
+    QByteArray optimize(const QImage &image);
+
+    static const int MAX_PALETTE_COLORS = 256;
+
+private:
+    QImage reducedImage(const QImage &image);
+};
+
+#endif // PNGOPTIMIZER_H
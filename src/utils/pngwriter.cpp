@@ -0,0 +1,330 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "pngwriter.h"
+#include <QtConcurrent>
+#include <QImage>
+#include <QFile>
+#include <QtEndian>
+#include <zlib.h>
+#include <limits>
+
+// PngWriter encodes an image as PNG using every core. The image is split
+// in horizontal strips which are filtered and deflated in parallel, like
+// pigz does. Every strip but the last one ends with a sync flush so the
+// raw deflate streams can be concatenated, the end of the previous strip
+// is used as dictionary so the compression barely suffers from the split.
+// The adler32 checksums of the strips are combined for the zlib trailer.
+
+namespace {
+
+// raw bytes compressed by a strip, like the blocks of pigz
+const int STRIP_SIZE = 128 * 1024;
+const int DICTIONARY_SIZE = 32 * 1024;
+
+using Filter = PngWriter::Filter;
+
+struct Settings {
+    int level;
+    int strategy;
+    Filter filter;
+};
+
+Settings presetSettings(const PngWriter::Preset preset) {
+    switch (preset) {
+    case PngWriter::FASTEST:
+        // the long runs of identical pixels of a screenshot are the
+        // cheapest thing to find
+        return Settings{1, Z_RLE, PngWriter::FILTER_NONE};
+    case PngWriter::SMALLEST:
+        return Settings{9, Z_DEFAULT_STRATEGY, PngWriter::FILTER_ADAPTIVE};
+    default:
+        return Settings{6, Z_DEFAULT_STRATEGY, PngWriter::FILTER_UP};
+    }
+}
+
+const QStringList PRESET_NAMES = {"fastest", "balanced", "smallest"};
+
+struct Strip {
+    int firstRow;
+    int rows;
+    QByteArray filtered;
+    QByteArray compressed;
+    uLong adler;
+    bool ok;
+};
+
+inline uchar paeth(const int a, const int b, const int c) {
+    int p = a + b - c;
+    int pa = qAbs(p - a);
+    int pb = qAbs(p - b);
+    int pc = qAbs(p - c);
+    if (pa <= pb && pa <= pc) {
+        return a;
+    }
+    return pb <= pc ? b : c;
+}
+
+// filterRow writes the filter type and the filtered bytes of a row, the
+// previous row is null for the first row of the image
+void filterRow(const Filter filter, const uchar *row, const uchar *previous,
+               const int size, const int bpp, uchar *out)
+{
+    out[0] = filter;
+    ++out;
+    for (int i = 0; i < size; ++i) {
+        int left = i >= bpp ? row[i - bpp] : 0;
+        int up = previous ? previous[i] : 0;
+        int upLeft = previous && i >= bpp ? previous[i - bpp] : 0;
+        switch (filter) {
+        case PngWriter::FILTER_SUB:
+            out[i] = row[i] - left;
+            break;
+        case PngWriter::FILTER_UP:
+            out[i] = row[i] - up;
+            break;
+        case PngWriter::FILTER_AVERAGE:
+            out[i] = row[i] - ((left + up) >> 1);
+            break;
+        case PngWriter::FILTER_PAETH:
+            out[i] = row[i] - paeth(left, up, upLeft);
+            break;
+        default:
+            out[i] = row[i];
+        }
+    }
+}
+
+// filterAdaptive chooses the filter with the smallest sum of absolute
+// differences, the usual heuristic of libpng
+void filterAdaptive(const uchar *row, const uchar *previous, const int size,
+                    const int bpp, uchar *out, uchar *scratch)
+{
+    quint64 best = std::numeric_limits<quint64>::max();
+    for (int f = PngWriter::FILTER_NONE; f <= PngWriter::FILTER_PAETH; ++f) {
+        filterRow(static_cast<Filter>(f), row, previous, size, bpp, scratch);
+        quint64 sum = 0;
+        for (int i = 1; i <= size; ++i) {
+            sum += static_cast<signed char>(scratch[i]) < 0 ?
+                        256 - scratch[i] : scratch[i];
+        }
+        if (sum < best) {
+            best = sum;
+            memcpy(out, scratch, size + 1);
+        }
+    }
+}
+
+void appendChunk(QByteArray &out, const char *type, const QByteArray &data) {
+    uchar length[4];
+    qToBigEndian<quint32>(data.size(), length);
+    out.append(reinterpret_cast<const char *>(length), 4);
+    int start = out.size();
+    out.append(type, 4);
+    out.append(data);
+    uLong crc = crc32(0, reinterpret_cast<const Bytef *>(out.constData() + start),
+                      out.size() - start);
+    uchar crcBytes[4];
+    qToBigEndian<quint32>(crc, crcBytes);
+    out.append(reinterpret_cast<const char *>(crcBytes), 4);
+}
+
+QByteArray bigEndian(const quint32 value) {
+    uchar bytes[4];
+    qToBigEndian<quint32>(value, bytes);
+    return QByteArray(reinterpret_cast<const char *>(bytes), 4);
+}
+
+} // unnamed namespace
+
+PngWriter::PngWriter(const Preset preset) :
+    m_preset(preset), m_filter(FILTER_NONE), m_filterSet(false)
+{
+
+}
+
+// setFilter replaces the filter of the preset
+void PngWriter::setFilter(const Filter filter) {
+    m_filter = filter;
+    m_filterSet = true;
+}
+
+PngWriter::Preset PngWriter::presetFromName(const QString &name) {
+    int index = PRESET_NAMES.indexOf(name.toLower());
+    return index < 0 ? BALANCED : static_cast<Preset>(index);
+}
+
+QString PngWriter::presetName(const Preset preset) {
+    return PRESET_NAMES.at(preset);
+}
+
+bool PngWriter::isPresetName(const QString &name) {
+    return PRESET_NAMES.contains(name.toLower());
+}
+
+bool PngWriter::write(const QImage &image, const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    bool ok = write(image, &file);
+    file.close();
+    return ok && file.error() == QFile::NoError;
+}
+
+bool PngWriter::write(const QImage &image, QIODevice *device) {
+    if (image.isNull()) {
+        return false;
+    }
+    Settings settings = presetSettings(m_preset);
+    if (m_filterSet) {
+        settings.filter = m_filter;
+    }
+    // 8 bits palette, RGB or RGBA, the byte order of the formats is the one
+    // of PNG
+    const bool indexed = image.format() == QImage::Format_Indexed8;
+    const bool alpha = image.hasAlphaChannel();
+    const int bpp = indexed ? 1 : alpha ? 4 : 3;
+    const QImage pixels = indexed ? image : image.convertToFormat(alpha ?
+                QImage::Format_RGBA8888 : QImage::Format_RGB888);
+    const int width = pixels.width();
+    const int rowSize = width * bpp;
+
+    // the strips have whole rows
+    const int stripRows = qMax(1, STRIP_SIZE / (rowSize + 1));
+    QVector<Strip> strips;
+    for (int row = 0; row < pixels.height(); row += stripRows) {
+        Strip s;
+        s.firstRow = row;
+        s.rows = qMin(stripRows, pixels.height() - row);
+        s.ok = false;
+        strips << s;
+    }
+
+    // filtering only needs the previous row of the image
+    QtConcurrent::blockingMap(strips, [&](Strip &s) {
+        s.filtered.resize(s.rows * (rowSize + 1));
+        uchar *out = reinterpret_cast<uchar *>(s.filtered.data());
+        QByteArray scratch(rowSize + 1, 0);
+        for (int i = 0; i < s.rows; ++i) {
+            int y = s.firstRow + i;
+            const uchar *line = pixels.constScanLine(y);
+            const uchar *previous = y > 0 ? pixels.constScanLine(y - 1) : nullptr;
+            if (settings.filter == FILTER_ADAPTIVE) {
+                filterAdaptive(line, previous, rowSize, bpp, out,
+                               reinterpret_cast<uchar *>(scratch.data()));
+            } else {
+                filterRow(settings.filter, line, previous, rowSize, bpp, out);
+            }
+            out += rowSize + 1;
+        }
+    });
+
+    // the strips are deflated once every filtered strip is available to
+    // be used as dictionary
+    const Strip *first = strips.constData();
+    const int last = strips.size() - 1;
+    QtConcurrent::blockingMap(strips, [&](Strip &s) {
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+        if (deflateInit2(&stream, settings.level, Z_DEFLATED, -15, 8,
+                         settings.strategy) != Z_OK)
+        {
+            return;
+        }
+        int index = &s - first;
+        if (index > 0) {
+            const QByteArray &previous = strips.at(index - 1).filtered;
+            int size = qMin(DICTIONARY_SIZE, previous.size());
+            deflateSetDictionary(&stream, reinterpret_cast<const Bytef *>(
+                        previous.constData() + previous.size() - size), size);
+        }
+        s.compressed.resize(deflateBound(&stream, s.filtered.size()) + 16);
+        stream.next_in = reinterpret_cast<Bytef *>(s.filtered.data());
+        stream.avail_in = s.filtered.size();
+        stream.next_out = reinterpret_cast<Bytef *>(s.compressed.data());
+        stream.avail_out = s.compressed.size();
+        int result = deflate(&stream, index == last ? Z_FINISH : Z_SYNC_FLUSH);
+        s.ok = (index == last ? result == Z_STREAM_END : result == Z_OK)
+                && stream.avail_in == 0;
+        s.compressed.resize(s.compressed.size() - stream.avail_out);
+        deflateEnd(&stream);
+        s.adler = adler32(1, reinterpret_cast<const Bytef *>(
+                              s.filtered.constData()), s.filtered.size());
+    });
+
+    QByteArray out("\x89PNG\r\n\x1a\n", 8);
+    QByteArray header = bigEndian(width) + bigEndian(pixels.height());
+    // bit depth, color type, compression, filter and interlace methods
+    header.append(char(8)).append(char(indexed ? 3 : alpha ? 6 : 2))
+            .append(char(0)).append(char(0)).append(char(0));
+    appendChunk(out, "IHDR", header);
+    if (indexed) {
+        QByteArray palette, transparency;
+        for (const QRgb color: pixels.colorTable()) {
+            palette.append(char(qRed(color))).append(char(qGreen(color)))
+                    .append(char(qBlue(color)));
+            transparency.append(char(qAlpha(color)));
+        }
+        appendChunk(out, "PLTE", palette);
+        if (alpha) {
+            appendChunk(out, "tRNS", transparency);
+        }
+    }
+    if (image.dotsPerMeterX() > 0 && image.dotsPerMeterY() > 0) {
+        QByteArray phys = bigEndian(image.dotsPerMeterX())
+                + bigEndian(image.dotsPerMeterY());
+        phys.append(char(1)); // meters
+        appendChunk(out, "pHYs", phys);
+    }
+    if (device->write(out) != out.size()) {
+        return false;
+    }
+
+    uLong adler = 1;
+    for (int i = 0; i < strips.size(); ++i) {
+        Strip &s = strips[i];
+        if (!s.ok) {
+            return false;
+        }
+        adler = adler32_combine(adler, s.adler, s.filtered.size());
+        QByteArray data;
+        if (i == 0) {
+            // zlib header of a 32K window, the level is only informative
+            int flags = settings.level >= 7 ? 3 : settings.level >= 6 ? 2
+                      : settings.level >= 2 ? 1 : 0;
+            int cmf = 0x78;
+            int flg = flags << 6;
+            flg += (31 - (cmf * 256 + flg) % 31) % 31;
+            data.append(char(cmf)).append(char(flg));
+        }
+        data.append(s.compressed);
+        if (i == last) {
+            data.append(bigEndian(adler));
+        }
+        s.filtered.clear();
+        s.compressed.clear();
+        out.clear();
+        appendChunk(out, "IDAT", data);
+        if (device->write(out) != out.size()) {
+            return false;
+        }
+    }
+    out.clear();
+    appendChunk(out, "IEND", QByteArray());
+    return device->write(out) == out.size();
+}
@@ -0,0 +1,62 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PNGWRITER_H
+#define PNGWRITER_H
+
+#include <QString>
+
+class QImage;
+class QIODevice;
+
+class PngWriter
+{
+public:
+    enum Preset {
+        FASTEST,
+        BALANCED,
+        SMALLEST,
+    };
+
+    enum Filter {
+        FILTER_NONE = 0,
+        FILTER_SUB = 1,
+        FILTER_UP = 2,
+        FILTER_AVERAGE = 3,
+        FILTER_PAETH = 4,
+        // chooses the filter per row, not stored in the file
+        FILTER_ADAPTIVE = 5,
+    };
+
+    explicit PngWriter(const Preset preset = BALANCED);
+
+    void setFilter(const Filter filter);
+
+    static Preset presetFromName(const QString &name);
+    static QString presetName(const Preset preset);
+    static bool isPresetName(const QString &name);
+
+    bool write(const QImage &image, QIODevice *device);
+    bool write(const QImage &image, const QString &path);
+
+private:
+    Preset m_preset;
+    Filter m_filter;
+    bool m_filterSet;
+};
+
+#endif // PNGWRITER_H
@@ -0,0 +1,147 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "qoiwriter.h"
+#include <QImage>
+#include <QtEndian>
+
+// QoiWriter encodes an image in the "Quite OK Image" format, a lossless
+// format which compresses a screenshot many times faster than PNG with a
+// similar size. Every pixel is written as a run of the previous pixel, a
+// reference to a recently seen pixel, a small difference with the
+// previous pixel or the complete pixel.
+// See https://qoiformat.org/qoi-specification.pdf
+
+namespace {
+
+const uchar OP_INDEX = 0x00;
+const uchar OP_DIFF = 0x40;
+const uchar OP_LUMA = 0x80;
+const uchar OP_RUN = 0xc0;
+const uchar OP_RGB = 0xfe;
+const uchar OP_RGBA = 0xff;
+
+const int HEADER_SIZE = 14;
+const int MAX_RUN = 62;
+const uchar END_MARKER[] = {0, 0, 0, 0, 0, 0, 0, 1};
+
+struct Pixel {
+    uchar r, g, b, a;
+    bool operator==(const Pixel &other) const {
+        return r == other.r && g == other.g && b == other.b && a == other.a;
+    }
+};
+
+inline int indexPosition(const Pixel &p) {
+    return (p.r * 3 + p.g * 5 + p.b * 7 + p.a * 11) % 64;
+}
+
+} // unnamed namespace
+
+QoiWriter::QoiWriter() {
+
+}
+
+// encode returns the QOI file of the image or an empty array if the image
+// is null
+QByteArray QoiWriter::encode(const QImage &image) {
+    if (image.isNull()) {
+        return QByteArray();
+    }
+    const bool alpha = image.hasAlphaChannel();
+    const QImage pixels = image.convertToFormat(QImage::Format_RGBA8888);
+    const int width = pixels.width();
+    const int height = pixels.height();
+
+    // the worst case is a complete pixel with its tag for every pixel
+    QByteArray res(HEADER_SIZE + width * height * (alpha ? 5 : 4)
+                   + sizeof(END_MARKER), Qt::Uninitialized);
+    uchar *out = reinterpret_cast<uchar *>(res.data());
+    memcpy(out, "qoif", 4);
+    qToBigEndian<quint32>(width, out + 4);
+    qToBigEndian<quint32>(height, out + 8);
+    out[12] = alpha ? 4 : 3;
+    out[13] = 0; // sRGB with linear alpha
+    out += HEADER_SIZE;
+
+    Pixel index[64];
+    memset(index, 0, sizeof(index));
+    Pixel previous = {0, 0, 0, 255};
+    int run = 0;
+    for (int y = 0; y < height; ++y) {
+        const Pixel *line = reinterpret_cast<const Pixel *>(
+                    pixels.constScanLine(y));
+        for (int x = 0; x < width; ++x) {
+            const Pixel p = line[x];
+            if (p == previous) {
+                ++run;
+                if (run == MAX_RUN) {
+                    *out++ = OP_RUN | (run - 1);
+                    run = 0;
+                }
+                continue;
+            }
+            if (run > 0) {
+                *out++ = OP_RUN | (run - 1);
+                run = 0;
+            }
+            int position = indexPosition(p);
+            if (index[position] == p) {
+                *out++ = OP_INDEX | position;
+            } else {
+                index[position] = p;
+                if (p.a == previous.a) {
+                    signed char vr = p.r - previous.r;
+                    signed char vg = p.g - previous.g;
+                    signed char vb = p.b - previous.b;
+                    signed char vgr = vr - vg;
+                    signed char vgb = vb - vg;
+                    if (vr > -3 && vr < 2 && vg > -3 && vg < 2
+                            && vb > -3 && vb < 2)
+                    {
+                        *out++ = OP_DIFF | (vr + 2) << 4 | (vg + 2) << 2
+                                | (vb + 2);
+                    } else if (vgr > -9 && vgr < 8 && vg > -33 && vg < 32
+                               && vgb > -9 && vgb < 8)
+                    {
+                        *out++ = OP_LUMA | (vg + 32);
+                        *out++ = (vgr + 8) << 4 | (vgb + 8);
+                    } else {
+                        *out++ = OP_RGB;
+                        *out++ = p.r;
+                        *out++ = p.g;
+                        *out++ = p.b;
+                    }
+                } else {
+                    *out++ = OP_RGBA;
+                    *out++ = p.r;
+                    *out++ = p.g;
+                    *out++ = p.b;
+                    *out++ = p.a;
+                }
+            }
+            previous = p;
+        }
+    }
+    if (run > 0) {
+        *out++ = OP_RUN | (run - 1);
+    }
+    memcpy(out, END_MARKER, sizeof(END_MARKER));
+    out += sizeof(END_MARKER);
+    res.resize(out - reinterpret_cast<uchar *>(res.data()));
+    return res;
+}
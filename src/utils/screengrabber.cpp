@@ -21,24 +21,112 @@
 #include <QGuiApplication>
 #include <QApplication>
 #include <QDesktopWidget>
+#ifdef USE_XCB_SHM
+#include "xshmgrabber.h"
+#endif
+
+// ScreenGrabber grabs the pixels of the screens. On X11 the MIT-SHM
+// extension is used when it's available.
+
+namespace {
+
+qreal screenDevicePixelRatio(QScreen *screen) {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 5, 0)
+    return screen->devicePixelRatio();
+#else
+    Q_UNUSED(screen);
+    return qApp->devicePixelRatio();
+#endif
+}
+
+} // unnamed namespace
 
 ScreenGrabber::ScreenGrabber(QObject *parent) : QObject(parent) {
 
 }
 
+// grabEntireDesktop returns the bounding rect of all the screens, the area
+// not covered by a screen is black
 QPixmap ScreenGrabber::grabEntireDesktop() {
+    TiledImage desktop = grabDesktop();
+    return QPixmap::fromImage(desktop.toImage());
+}
+
+// grabDesktop grabs every screen at its device pixel ratio and composes them
+// in a TiledImage with the highest one, the areas of the image are the
+// screens. The space between screens is neither grabbed nor stored.
+TiledImage ScreenGrabber::grabDesktop() {
     QRect geometry;
     for (QScreen *const screen : QGuiApplication::screens()) {
         geometry = geometry.united(screen->geometry());
     }
+    return grabArea(geometry);
+}
 
-    QPixmap p(QApplication::primaryScreen()->grabWindow(
-                  QApplication::desktop()->winId(),
-                  geometry.x(),
-                  geometry.y(),
-                  geometry.width(),
-                  geometry.height())
-              );
-    p.setDevicePixelRatio(QApplication::desktop()->devicePixelRatio());
-    return p;
+// grabScreen grabs an area of the screen with the passed index, relative to
+// its top left corner, or the whole screen if the area is empty. It returns
+// a null image when the screen doesn't exist.
+TiledImage ScreenGrabber::grabScreen(const int index, const QRect &area) {
+    QList<QScreen *> screens = QGuiApplication::screens();
+    if (index < 0 || index >= screens.size()) {
+        return TiledImage();
+    }
+    QRect geometry = screens.at(index)->geometry();
+    if (!area.isEmpty()) {
+        geometry = area.translated(geometry.topLeft()).intersected(geometry);
+    }
+    return grabArea(geometry);
+}
+
+// grabArea grabs the parts of the screens inside of an area of the desktop
+// (in logical coordinates). Only the pixels of the area are grabbed, with
+// the highest device pixel ratio of the screens it covers.
+TiledImage ScreenGrabber::grabArea(const QRect &area) {
+    QList<QScreen *> screens;
+    qreal devicePixelRatio = 1;
+    for (QScreen *const screen : QGuiApplication::screens()) {
+        if (screen->geometry().intersects(area)) {
+            screens << screen;
+            devicePixelRatio = qMax(devicePixelRatio,
+                                    screenDevicePixelRatio(screen));
+        }
+    }
+    if (screens.isEmpty() || area.isEmpty()) {
+        return TiledImage();
+    }
+
+    QVector<QImage> images;
+#ifdef USE_XCB_SHM
+    // the screens are grabbed with pipelined requests, the native geometry
+    // of a screen keeps its logical position
+    QVector<QRect> nativeAreas;
+    for (QScreen *const screen : screens) {
+        QRect g = screen->geometry();
+        QRect r = g.intersected(area);
+        qreal ratio = screenDevicePixelRatio(screen);
+        nativeAreas << QRect(g.topLeft() + (r.topLeft() - g.topLeft()) * ratio,
+                             r.size() * ratio);
+    }
+    images = XShmGrabber::instance()->grab(nativeAreas);
+#endif
+
+    QVector<TiledImage::Source> sources;
+    for (int i = 0; i < screens.size(); ++i) {
+        QScreen *const screen = screens.at(i);
+        QRect r = screen->geometry().intersected(area);
+        TiledImage::Source source;
+        source.image = images.value(i);
+        if (source.image.isNull()) {
+            source.image = screen->grabWindow(QApplication::desktop()->winId(),
+                                              r.x(), r.y(),
+                                              r.width(), r.height()).toImage();
+        }
+        source.rect = QRectF((r.x() - area.x()) * devicePixelRatio,
+                             (r.y() - area.y()) * devicePixelRatio,
+                             r.width() * devicePixelRatio,
+                             r.height() * devicePixelRatio).toAlignedRect();
+        sources << source;
+    }
+    return TiledImage(area.size() * devicePixelRatio, devicePixelRatio,
+                      sources);
 }
@@ -18,6 +18,7 @@
 #ifndef SCREENGRABBER_H
 #define SCREENGRABBER_H
 
+#include "src/capture/tiledimage.h"
 #include <QObject>
 
 class ScreenGrabber : public QObject
@@ -26,6 +27,9 @@ class ScreenGrabber : public QObject
 public:
     explicit ScreenGrabber(QObject *parent = nullptr);
     QPixmap grabEntireDesktop();
+    TiledImage grabDesktop();
+    TiledImage grabScreen(const int index, const QRect &area = QRect());
+    TiledImage grabArea(const QRect &area);
 
 };
 
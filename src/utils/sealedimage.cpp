@@ -0,0 +1,196 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "sealedimage.h"
+#include "src/capture/tiledimage.h"
+#include <QIODevice>
+#include <QObject>
+#include <cerrno>
+#include <cstring>
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// SealedImage composes a capture in an anonymous memory file (memfd) which
+// can be sent to another process through DBus. The file is sealed once
+// written, so the receiver can map it knowing it won't change nor shrink,
+// and the pixels are never copied through the bus or the filesystem.
+
+#ifdef Q_OS_LINUX
+// the headers of older systems don't have the memfd definitions
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+#ifndef MFD_ALLOW_SEALING
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS 1033
+#define F_SEAL_SEAL 0x0001
+#define F_SEAL_SHRINK 0x0002
+#define F_SEAL_GROW 0x0004
+#define F_SEAL_WRITE 0x0008
+#endif
+#endif
+
+namespace {
+
+int createMemfd(const char *name) {
+#if defined(Q_OS_LINUX) && defined(SYS_memfd_create)
+    return syscall(SYS_memfd_create, name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#else
+    Q_UNUSED(name);
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+} // unnamed namespace
+
+const QString SealedImage::FORMAT = "XRGB8888";
+
+SealedImage::SealedImage(const TiledImage &capture) :
+    m_fd(-1), m_stride(0), m_size(capture.size())
+{
+#ifdef Q_OS_LINUX
+    m_stride = m_size.width() * 4;
+    size_t bytes = static_cast<size_t>(m_stride) * m_size.height();
+    m_fd = createMemfd("flameshot-capture");
+    if (m_fd < 0) {
+        fail(QObject::tr("Unable to create the shared memory: ")
+             + strerror(errno));
+        return;
+    }
+    if (ftruncate(m_fd, bytes) != 0) {
+        fail(QObject::tr("Unable to resize the shared memory: ")
+             + strerror(errno));
+        return;
+    }
+    void *data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      m_fd, 0);
+    if (data == MAP_FAILED) {
+        fail(QObject::tr("Unable to map the shared memory: ")
+             + strerror(errno));
+        return;
+    }
+    {
+        QImage target(static_cast<uchar *>(data), m_size.width(),
+                      m_size.height(), m_stride, QImage::Format_RGB32);
+        capture.copyTo(target);
+    }
+    // the write seal requires no writable mapping
+    munmap(data, bytes);
+    if (fcntl(m_fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW
+              | F_SEAL_WRITE | F_SEAL_SEAL) != 0)
+    {
+        fail(QObject::tr("Unable to seal the shared memory: ")
+             + strerror(errno));
+    }
+#else
+    fail(QObject::tr("The shared memory isn't supported in this system"));
+#endif
+}
+
+SealedImage::~SealedImage() {
+#ifdef Q_OS_LINUX
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+#endif
+}
+
+bool SealedImage::isValid() const {
+    return m_fd >= 0;
+}
+
+// fileDescriptor returns the descriptor of the memory file, it's closed
+// with the object
+int SealedImage::fileDescriptor() const {
+    return m_fd;
+}
+
+int SealedImage::stride() const {
+    return m_stride;
+}
+
+QSize SealedImage::size() const {
+    return m_size;
+}
+
+QString SealedImage::errorString() const {
+    return m_errorString;
+}
+
+// writeMapped writes the content of a file descriptor received by a client
+// to a device, the memory is mapped instead of read
+bool SealedImage::writeMapped(const int fd, const qint64 size,
+                              QIODevice *device)
+{
+#ifdef Q_OS_LINUX
+    void *data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    bool ok = device->write(static_cast<const char *>(data), size) == size;
+    munmap(data, size);
+    return ok;
+#else
+    Q_UNUSED(fd);
+    Q_UNUSED(size);
+    Q_UNUSED(device);
+    return false;
+#endif
+}
+
+// readMapped returns a copy of the pixels of a file descriptor received by
+// a client, or a null image if it can't be mapped
+QImage SealedImage::readMapped(const int fd, const QSize &size,
+                               const int stride)
+{
+#ifdef Q_OS_LINUX
+    if (size.isEmpty() || stride < size.width() * 4) {
+        return QImage();
+    }
+    qint64 length = static_cast<qint64>(stride) * size.height();
+    void *data = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        return QImage();
+    }
+    QImage image = QImage(static_cast<const uchar *>(data), size.width(),
+                          size.height(), stride, QImage::Format_RGB32).copy();
+    munmap(data, length);
+    return image;
+#else
+    Q_UNUSED(fd);
+    Q_UNUSED(size);
+    Q_UNUSED(stride);
+    return QImage();
+#endif
+}
+
+void SealedImage::fail(const QString &message) {
+    m_errorString = message;
+#ifdef Q_OS_LINUX
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+#endif
+    m_fd = -1;
+}
@@ -0,0 +1,59 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SEALEDIMAGE_H
+#define SEALEDIMAGE_H
+
+#include <QString>
+#include <QSize>
+
+class TiledImage;
+class QIODevice;
+class QImage;
+
+class SealedImage
+{
+public:
+    explicit SealedImage(const TiledImage &capture);
+    ~SealedImage();
+
+    SealedImage(const SealedImage&) = delete;
+    void operator =(const SealedImage&) = delete;
+
+    // the pixels are 32 bit 0xffRRGGBB values in the byte order of the
+    // machine, like the XRGB8888 format of DRM
+    static const QString FORMAT;
+
+    bool isValid() const;
+    int fileDescriptor() const;
+    int stride() const;
+    QSize size() const;
+    QString errorString() const;
+
+    static bool writeMapped(const int fd, const qint64 size, QIODevice *device);
+    static QImage readMapped(const int fd, const QSize &size, const int stride);
+
+private:
+    int m_fd;
+    int m_stride;
+    QSize m_size;
+    QString m_errorString;
+
+    void fail(const QString &message);
+};
+
+#endif // SEALEDIMAGE_H
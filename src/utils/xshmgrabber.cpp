@@ -0,0 +1,188 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "xshmgrabber.h"
+#include <QGuiApplication>
+#include <xcb/xcb.h>
+#include <xcb/shm.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <cstdlib>
+
+// XShmGrabber reads the root window of the X server with the MIT-SHM
+// extension. The pixels are written by the server in a shared memory
+// segment, which is kept between grabs, instead of being sent through the
+// connection. It isn't available out of X11 or with a remote server, then
+// ScreenGrabber uses the Qt grab.
+
+XShmGrabber *XShmGrabber::instance() {
+    static XShmGrabber grabber;
+    return &grabber;
+}
+
+XShmGrabber::XShmGrabber() :
+    m_connection(nullptr), m_root(0), m_available(false),
+    m_segment(0), m_shmId(-1), m_data(nullptr), m_capacity(0)
+{
+    if (QGuiApplication::platformName() != QLatin1String("xcb")) {
+        return;
+    }
+    int screenNumber = 0;
+    m_connection = xcb_connect(nullptr, &screenNumber);
+    if (xcb_connection_has_error(m_connection)) {
+        return;
+    }
+    const xcb_query_extension_reply_t *extension =
+            xcb_get_extension_data(m_connection, &xcb_shm_id);
+    if (!extension || !extension->present) {
+        return;
+    }
+    xcb_screen_iterator_t it =
+            xcb_setup_roots_iterator(xcb_get_setup(m_connection));
+    for (int i = 0; i < screenNumber && it.rem; ++i) {
+        xcb_screen_next(&it);
+    }
+    if (!it.rem) {
+        return;
+    }
+    m_root = it.data->root;
+
+    // the pixels are wrapped in a QImage, only 32 bits per pixel with a
+    // depth of 24 or 32 are supported
+    int depth = it.data->root_depth;
+    if (depth != 24 && depth != 32) {
+        return;
+    }
+    const xcb_setup_t *setup = xcb_get_setup(m_connection);
+    xcb_format_iterator_t format = xcb_setup_pixmap_formats_iterator(setup);
+    for (; format.rem; xcb_format_next(&format)) {
+        if (format.data->depth == depth) {
+            m_available = format.data->bits_per_pixel == 32;
+            break;
+        }
+    }
+}
+
+XShmGrabber::~XShmGrabber() {
+    releaseSegment();
+    if (m_connection) {
+        xcb_disconnect(m_connection);
+    }
+}
+
+bool XShmGrabber::isAvailable() const {
+    return m_available;
+}
+
+// grab returns the areas of the root window (in device pixels) or an empty
+// vector if they can't be grabbed. All the requests are sent before waiting
+// for the replies, each area is written in its own part of the segment. The
+// images use the shared memory, they are valid until the next grab.
+QVector<QImage> XShmGrabber::grab(const QVector<QRect> &areas) {
+    QVector<QImage> res;
+    if (!m_available) {
+        return res;
+    }
+    int bytes = 0;
+    for (const QRect &area: areas) {
+        bytes += area.width() * area.height() * 4;
+    }
+    if (!reserveSegment(bytes)) {
+        // the segment can't be attached by the server, e.g. remote display
+        m_available = false;
+        return res;
+    }
+
+    QVector<xcb_shm_get_image_cookie_t> cookies;
+    int offset = 0;
+    for (const QRect &area: areas) {
+        cookies << xcb_shm_get_image(
+                       m_connection, m_root, area.x(), area.y(),
+                       area.width(), area.height(), ~0u,
+                       XCB_IMAGE_FORMAT_Z_PIXMAP, m_segment, offset);
+        offset += area.width() * area.height() * 4;
+    }
+
+    bool failed = false;
+    offset = 0;
+    for (int i = 0; i < areas.size(); ++i) {
+        const QRect &area = areas.at(i);
+        xcb_generic_error_t *error = nullptr;
+        xcb_shm_get_image_reply_t *reply =
+                xcb_shm_get_image_reply(m_connection, cookies.at(i), &error);
+        if (error) {
+            free(error);
+        }
+        if (!reply) {
+            failed = true;
+        }
+        free(reply);
+        res << QImage(m_data + offset, area.width(), area.height(),
+                      area.width() * 4, QImage::Format_RGB32);
+        offset += area.width() * area.height() * 4;
+    }
+    if (failed) {
+        res.clear();
+    }
+    return res;
+}
+
+// reserveSegment makes the shared memory segment at least of the passed
+// size, a bigger one is kept
+bool XShmGrabber::reserveSegment(const int bytes) {
+    if (bytes <= m_capacity) {
+        return true;
+    }
+    releaseSegment();
+    m_shmId = shmget(IPC_PRIVATE, bytes, IPC_CREAT | 0600);
+    if (m_shmId < 0) {
+        return false;
+    }
+    void *data = shmat(m_shmId, nullptr, 0);
+    if (data == reinterpret_cast<void *>(-1)) {
+        shmctl(m_shmId, IPC_RMID, nullptr);
+        m_shmId = -1;
+        return false;
+    }
+    m_data = static_cast<uchar *>(data);
+    m_segment = xcb_generate_id(m_connection);
+    xcb_generic_error_t *error = xcb_request_check(m_connection,
+            xcb_shm_attach_checked(m_connection, m_segment, m_shmId, false));
+    // the segment is destroyed when both processes detach it
+    shmctl(m_shmId, IPC_RMID, nullptr);
+    if (error) {
+        free(error);
+        shmdt(m_data);
+        m_data = nullptr;
+        m_shmId = -1;
+        return false;
+    }
+    m_capacity = bytes;
+    return true;
+}
+
+void XShmGrabber::releaseSegment() {
+    if (!m_data) {
+        return;
+    }
+    xcb_shm_detach(m_connection, m_segment);
+    xcb_flush(m_connection);
+    shmdt(m_data);
+    m_data = nullptr;
+    m_shmId = -1;
+    m_capacity = 0;
+}
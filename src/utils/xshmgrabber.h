@@ -0,0 +1,54 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef XSHMGRABBER_H
+#define XSHMGRABBER_H
+
+#include <QImage>
+#include <QRect>
+#include <QVector>
+
+struct xcb_connection_t;
+
+class XShmGrabber
+{
+public:
+    static XShmGrabber *instance();
+
+    bool isAvailable() const;
+    QVector<QImage> grab(const QVector<QRect> &areas);
+
+private:
+    XShmGrabber();
+    ~XShmGrabber();
+    Q_DISABLE_COPY(XShmGrabber)
+
+    bool reserveSegment(const int bytes);
+    void releaseSegment();
+
+    xcb_connection_t *m_connection;
+    quint32 m_root;
+    bool m_available;
+
+    // shared memory segment reused between grabs
+    quint32 m_segment;
+    int m_shmId;
+    uchar *m_data;
+    int m_capacity;
+};
+
+#endif // XSHMGRABBER_H
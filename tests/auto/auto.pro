@@ -0,0 +1,5 @@
+# Unit tests, they run on the offscreen platform
+
+TEMPLATE = subdirs
+
+SUBDIRS += capturemodification
@@ -0,0 +1,58 @@
+# Tests of the simplification of the paths drawn in the capture, run it
+# with `make check`
+
+QT       += core gui widgets testlib
+QT       += concurrent network
+
+CONFIG   += c++11
+CONFIG   -= app_bundle
+
+TARGET = tst_capturemodification
+TEMPLATE = app
+
+ROOT = $$PWD/../../..
+INCLUDEPATH += $$ROOT
+
+SOURCES += tst_capturemodification.cpp \
+    $$ROOT/src/capture/capturemodification.cpp \
+    $$ROOT/src/capture/widget/capturebutton.cpp \
+    $$ROOT/src/capture/tools/capturetool.cpp \
+    $$ROOT/src/capture/tools/penciltool.cpp \
+    $$ROOT/src/capture/tools/undotool.cpp \
+    $$ROOT/src/capture/tools/arrowtool.cpp \
+    $$ROOT/src/capture/tools/circletool.cpp \
+    $$ROOT/src/capture/tools/copytool.cpp \
+    $$ROOT/src/capture/tools/exittool.cpp \
+    $$ROOT/src/capture/tools/imguruploadertool.cpp \
+    $$ROOT/src/capture/tools/linetool.cpp \
+    $$ROOT/src/capture/tools/markertool.cpp \
+    $$ROOT/src/capture/tools/movetool.cpp \
+    $$ROOT/src/capture/tools/rectangletool.cpp \
+    $$ROOT/src/capture/tools/savetool.cpp \
+    $$ROOT/src/capture/tools/selectiontool.cpp \
+    $$ROOT/src/capture/tools/sizeindicatortool.cpp \
+    $$ROOT/src/capture/tools/toolfactory.cpp \
+    $$ROOT/src/utils/confighandler.cpp
+
+HEADERS += \
+    $$ROOT/src/capture/capturemodification.h \
+    $$ROOT/src/capture/widget/capturebutton.h \
+    $$ROOT/src/capture/tools/capturetool.h \
+    $$ROOT/src/capture/tools/penciltool.h \
+    $$ROOT/src/capture/tools/undotool.h \
+    $$ROOT/src/capture/tools/arrowtool.h \
+    $$ROOT/src/capture/tools/circletool.h \
+    $$ROOT/src/capture/tools/copytool.h \
+    $$ROOT/src/capture/tools/exittool.h \
+    $$ROOT/src/capture/tools/imguruploadertool.h \
+    $$ROOT/src/capture/tools/linetool.h \
+    $$ROOT/src/capture/tools/markertool.h \
+    $$ROOT/src/capture/tools/movetool.h \
+    $$ROOT/src/capture/tools/rectangletool.h \
+    $$ROOT/src/capture/tools/savetool.h \
+    $$ROOT/src/capture/tools/selectiontool.h \
+    $$ROOT/src/capture/tools/sizeindicatortool.h \
+    $$ROOT/src/capture/tools/toolfactory.h \
+    $$ROOT/src/utils/confighandler.h
+
+CONFIG += testcase
@@ -0,0 +1,145 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "src/capture/capturemodification.h"
+#include <QApplication>
+#include <QtTest>
+#include <QLineF>
+#include <qmath.h>
+
+namespace {
+
+// ALIGNMENT_TOLERANCE of capturemodification.cpp
+const qreal TOLERANCE = 0.75;
+// points closer than MIN_POINT_DISTANCE to the last one of the path stay
+// within this distance of it
+const qreal JITTER_TOLERANCE = 1;
+
+// arc returns the points of a quarter of a circle drawn slowly, with
+// the mouse moving a few pixels between the events
+QVector<QPoint> arc(const int radius, const int step) {
+    const QPoint center(600, 600);
+    QVector<QPoint> points;
+    int count = qRound(radius * M_PI / 2 / step);
+    for (int i = 0; i <= count; ++i) {
+        qreal angle = i * step / qreal(radius);
+        QPoint p = center + QPoint(qRound(radius * qCos(angle)),
+                                   qRound(radius * qSin(angle)));
+        if (points.isEmpty() || points.last() != p) {
+            points << p;
+        }
+    }
+    return points;
+}
+
+qreal distanceToSegment(const QPointF &p, const QLineF &segment) {
+    QPointF d = segment.p2() - segment.p1();
+    QPointF v = p - segment.p1();
+    qreal lengthSquared = QPointF::dotProduct(d, d);
+    qreal projection = QPointF::dotProduct(v, d);
+    if (lengthSquared == 0 || projection <= 0) {
+        return QLineF(p, segment.p1()).length();
+    } else if (projection >= lengthSquared) {
+        return QLineF(p, segment.p2()).length();
+    }
+    return qAbs(d.x() * v.y() - d.y() * v.x()) / qSqrt(lengthSquared);
+}
+
+// deviation returns the largest distance from a drawn point to the path
+qreal deviation(const QVector<QPoint> &drawn, const QVector<QPoint> &path) {
+    qreal res = 0;
+    for (const QPoint &p: drawn) {
+        qreal distance = QLineF(p, path.first()).length();
+        for (int i = 1; i < path.size(); ++i) {
+            distance = qMin(distance, distanceToSegment(
+                                p, QLineF(path.at(i - 1), path.at(i))));
+        }
+        res = qMax(res, distance);
+    }
+    return res;
+}
+
+} // unnamed namespace
+
+class CaptureModificationTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void slowArc_data();
+    void slowArc();
+    void straightLine();
+};
+
+void CaptureModificationTest::slowArc_data() {
+    QTest::addColumn<int>("radius");
+    QTest::addColumn<int>("step");
+    QTest::addColumn<qreal>("tolerance");
+    for (const int radius: {200, 350, 500}) {
+        for (const int step: {1, 2, 3, 4}) {
+            QString tag = QStringLiteral("r%1 step%2").arg(radius).arg(step);
+            // the steps of 1px are closer than MIN_POINT_DISTANCE
+            QTest::newRow(qPrintable(tag)) << radius << step
+                    << (step == 1 ? JITTER_TOLERANCE : TOLERANCE);
+        }
+    }
+}
+
+// slowArc checks that the error of the simplification doesn't accumulate
+// when every point is close to the line joining its neighbours
+void CaptureModificationTest::slowArc() {
+    QFETCH(int, radius);
+    QFETCH(int, step);
+    QFETCH(qreal, tolerance);
+    QVector<QPoint> drawn = arc(radius, step);
+    CaptureModification modification(CaptureButton::TYPE_PENCIL,
+                                     drawn.first(), QColor(Qt::red), 2);
+    for (int i = 1; i < drawn.size(); ++i) {
+        modification.addPoint(drawn.at(i));
+    }
+    const QVector<QPoint> &path = modification.points();
+    QVERIFY(path.size() < drawn.size() / 2);
+    qreal error = deviation(drawn, path);
+    QVERIFY2(error <= tolerance + 1e-9,
+             qPrintable(QStringLiteral("deviation of %1px").arg(error)));
+}
+
+void CaptureModificationTest::straightLine() {
+    CaptureModification modification(CaptureButton::TYPE_PENCIL,
+                                     QPoint(0, 0), QColor(Qt::red), 2);
+    for (int x = 3; x <= 90; x += 3) {
+        modification.addPoint(QPoint(x, x / 2));
+    }
+    const QVector<QPoint> &path = modification.points();
+    QVERIFY(path.size() <= 3);
+    QCOMPARE(path.last(), QPoint(90, 45));
+}
+
+int main(int argc, char *argv[]) {
+    // the tools don't need a display
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+    // the configuration of the user isn't read
+    app.setApplicationName("flameshot-tests");
+    app.setOrganizationName("Dharkael");
+    CaptureModificationTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_capturemodification.moc"
@@ -0,0 +1,74 @@
+# Benchmark of the Screenshot annotation pipeline. After building it:
+#   make benchmark  runs it and writes benchmark.csv and benchmark.xml
+#   make baseline   stores benchmark.csv as the baseline
+#   make compare    compares benchmark.csv with the baseline, it fails when
+#                   a benchmark is slower than the baseline by more than
+#                   TOLERANCE percent
+# The baseline depends on the machine, it is kept in the build directory.
+
+QT       += core gui widgets testlib
+QT       += concurrent network
+
+CONFIG   += c++11
+CONFIG   -= app_bundle
+
+TARGET = tst_annotation
+TEMPLATE = app
+
+ROOT = $$PWD/../../..
+INCLUDEPATH += $$ROOT
+
+SOURCES += tst_annotation.cpp \
+    $$ROOT/src/capture/screenshot.cpp \
+    $$ROOT/src/capture/tiledimage.cpp \
+    $$ROOT/src/capture/renderstatistics.cpp \
+    $$ROOT/src/capture/capturemodification.cpp \
+    $$ROOT/src/capture/widget/capturebutton.cpp \
+    $$ROOT/src/capture/tools/capturetool.cpp \
+    $$ROOT/src/capture/tools/penciltool.cpp \
+    $$ROOT/src/capture/tools/undotool.cpp \
+    $$ROOT/src/capture/tools/arrowtool.cpp \
+    $$ROOT/src/capture/tools/circletool.cpp \
+    $$ROOT/src/capture/tools/copytool.cpp \
+    $$ROOT/src/capture/tools/exittool.cpp \
+    $$ROOT/src/capture/tools/imguruploadertool.cpp \
+    $$ROOT/src/capture/tools/linetool.cpp \
+    $$ROOT/src/capture/tools/markertool.cpp \
+    $$ROOT/src/capture/tools/movetool.cpp \
+    $$ROOT/src/capture/tools/rectangletool.cpp \
+    $$ROOT/src/capture/tools/savetool.cpp \
+    $$ROOT/src/capture/tools/selectiontool.cpp \
+    $$ROOT/src/capture/tools/sizeindicatortool.cpp \
+    $$ROOT/src/capture/tools/toolfactory.cpp \
+    $$ROOT/src/utils/confighandler.cpp
+
+HEADERS += \
+    $$ROOT/src/capture/screenshot.h \
+    $$ROOT/src/capture/tiledimage.h \
+    $$ROOT/src/capture/renderstatistics.h \
+    $$ROOT/src/capture/capturemodification.h \
+    $$ROOT/src/capture/widget/capturebutton.h \
+    $$ROOT/src/capture/tools/capturetool.h \
+    $$ROOT/src/capture/tools/penciltool.h \
+    $$ROOT/src/capture/tools/undotool.h \
+    $$ROOT/src/capture/tools/arrowtool.h \
+    $$ROOT/src/capture/tools/circletool.h \
+    $$ROOT/src/capture/tools/copytool.h \
+    $$ROOT/src/capture/tools/exittool.h \
+    $$ROOT/src/capture/tools/imguruploadertool.h \
+    $$ROOT/src/capture/tools/linetool.h \
+    $$ROOT/src/capture/tools/markertool.h \
+    $$ROOT/src/capture/tools/movetool.h \
+    $$ROOT/src/capture/tools/rectangletool.h \
+    $$ROOT/src/capture/tools/savetool.h \
+    $$ROOT/src/capture/tools/selectiontool.h \
+    $$ROOT/src/capture/tools/sizeindicatortool.h \
+    $$ROOT/src/capture/tools/toolfactory.h \
+    $$ROOT/src/utils/confighandler.h
+
+isEmpty(TOLERANCE): TOLERANCE = 10
+
+benchmark.commands = ./$$TARGET -o benchmark.csv,csv -o benchmark.xml,xml -o -,txt
+baseline.commands = $$QMAKE_COPY benchmark.csv baseline.csv
+compare.commands = ./$$TARGET --compare baseline.csv benchmark.csv $$TOLERANCE
+QMAKE_EXTRA_TARGETS += benchmark baseline compare
@@ -0,0 +1,337 @@
+// Copyright 2017 Alejandro Sirgo Rica
+//
+// This file is part of Flameshot.
+//
+//     Flameshot is free software: you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation, either version 3 of the License, or
+//     (at your option) any later version.
+//
+//     Flameshot is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License
+//     along with Flameshot.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "src/capture/screenshot.h"
+#include "src/capture/tiledimage.h"
+#include "src/capture/capturemodification.h"
+#include "src/capture/tools/capturetool.h"
+#include "src/capture/tools/toolfactory.h"
+#include "src/capture/widget/capturebutton.h"
+#include <QApplication>
+#include <QtTest>
+#include <QPainter>
+#include <QFile>
+#include <QTextStream>
+#include <QMap>
+#include <qmath.h>
+
+// AnnotationBenchmark measures the painting of the modifications in a
+// Screenshot with synthetic strokes of every drawing tool, in canvases of
+// the sizes of the usual screen layouts.
+// The results are written in a machine readable format with the -o option
+// of QTest, "--compare BASELINE RESULTS [TOLERANCE]" compares two result
+// files in the csv format instead of running the benchmarks.
+
+namespace {
+
+// screens of a layout, in logical pixels
+struct Layout {
+    const char *name;
+    QVector<QRect> screens;
+};
+
+const int POINT_COUNT = 200;
+const int MODIFICATION_COUNT = 32;
+const int THICKNESS = 4;
+const qreal DEFAULT_TOLERANCE = 10;
+
+QVector<Layout> layouts() {
+    QVector<Layout> res;
+    res << Layout{"1080p", {QRect(0, 0, 1920, 1080)}}
+        << Layout{"4K", {QRect(0, 0, 3840, 2160)}}
+        << Layout{"8K", {QRect(0, 0, 7680, 4320)}}
+        // a landscape screen and a portrait one around a 1440p screen,
+        // with areas of the canvas not covered by any screen
+        << Layout{"3-monitors", {QRect(0, 360, 1920, 1080),
+                                 QRect(1920, 0, 2560, 1440),
+                                 QRect(4480, 0, 1080, 1920)}};
+    return res;
+}
+
+// createCanvas composes a synthetic screenshot of the screens of the
+// layout, every screen shows a gradient so the tiles aren't uniform
+TiledImage createCanvas(const Layout &layout) {
+    QRect canvas;
+    QVector<TiledImage::Source> sources;
+    for (const QRect &screen: layout.screens) {
+        canvas = canvas.united(screen);
+        QImage image(screen.size(), QImage::Format_RGB32);
+        QPainter painter(&image);
+        QLinearGradient gradient(0, 0, screen.width(), screen.height());
+        gradient.setColorAt(0, QColor(30, 90, 160));
+        gradient.setColorAt(1, QColor(230, 200, 120));
+        painter.fillRect(image.rect(), gradient);
+        painter.end();
+        sources << TiledImage::Source{screen, image};
+    }
+    return TiledImage(canvas.size(), 1, sources);
+}
+
+// stroke returns the points of a wave crossing the area from left to right
+QVector<QPoint> stroke(const QRect &area) {
+    QVector<QPoint> points;
+    points.reserve(POINT_COUNT);
+    for (int i = 0; i < POINT_COUNT; ++i) {
+        qreal progress = i / qreal(POINT_COUNT - 1);
+        points << QPoint(area.left() + qRound(area.width() * progress),
+                         area.center().y() + qRound(
+                             qSin(progress * 4 * M_PI) * area.height() / 4));
+    }
+    return points;
+}
+
+CaptureModification createModification(const CaptureButton::ButtonType type,
+                                       const QVector<QPoint> &points)
+{
+    CaptureModification modification(type, points.first(), QColor(Qt::red),
+                                      THICKNESS);
+    for (int i = 1; i < points.size(); ++i) {
+        modification.addPoint(points.at(i));
+    }
+    return modification;
+}
+
+// modificationStream returns modifications of the tool covering the
+// canvas in horizontal bands
+QVector<CaptureModification> modificationStream(
+        const CaptureButton::ButtonType type, const QSize &canvas)
+{
+    QVector<CaptureModification> res;
+    int bandHeight = canvas.height() / MODIFICATION_COUNT;
+    for (int i = 0; i < MODIFICATION_COUNT; ++i) {
+        QRect band(0, i * bandHeight, canvas.width(), bandHeight);
+        res << createModification(type, stroke(band));
+    }
+    return res;
+}
+
+// readResults returns the time per iteration of the benchmarks of a QTest
+// result file in the csv format. The benchmarks are identified by their
+// quoted fields (function, tag and metric), the value is the first field
+// which isn't quoted.
+QMap<QString, qreal> readResults(const QString &path, bool &ok) {
+    QMap<QString, qreal> res;
+    QFile file(path);
+    ok = file.open(QIODevice::ReadOnly | QIODevice::Text);
+    if (!ok) {
+        return res;
+    }
+    QTextStream stream(&file);
+    while (!stream.atEnd()) {
+        QString line = stream.readLine();
+        QStringList key;
+        int pos = 0;
+        while (pos < line.size() && line.at(pos) == QLatin1Char('"')) {
+            int end = line.indexOf(QLatin1Char('"'), pos + 1);
+            if (end < 0) {
+                break;
+            }
+            key << line.mid(pos + 1, end - pos - 1);
+            pos = end + 2;
+        }
+        bool isNumber = false;
+        qreal value = line.mid(pos).section(QLatin1Char(','), 0, 0)
+                .toDouble(&isNumber);
+        if (!key.isEmpty() && isNumber) {
+            res.insert(key.join(QStringLiteral(" ")), value);
+        }
+    }
+    return res;
+}
+
+// compareResults prints the change of every benchmark of the baseline and
+// returns 1 when one of them is slower than the tolerance (a percentage)
+int compareResults(const QString &baselinePath, const QString &resultsPath,
+                   const qreal tolerance)
+{
+    QTextStream out(stdout);
+    bool ok = false;
+    QMap<QString, qreal> baseline = readResults(baselinePath, ok);
+    if (!ok) {
+        out << "Unable to read the baseline " << baselinePath << "\n";
+        return 1;
+    }
+    QMap<QString, qreal> results = readResults(resultsPath, ok);
+    if (!ok) {
+        out << "Unable to read the results " << resultsPath << "\n";
+        return 1;
+    }
+    int regressions = 0;
+    for (auto it = baseline.constBegin(); it != baseline.constEnd(); ++it) {
+        if (!results.contains(it.key())) {
+            out << "MISSING    " << it.key() << "\n";
+            continue;
+        }
+        qreal result = results.value(it.key());
+        qreal change = it.value() > 0 ?
+                    (result - it.value()) * 100 / it.value() : 0;
+        bool regression = change > tolerance;
+        regressions += regression ? 1 : 0;
+        out << (regression ? "REGRESSION " : "ok         ") << it.key()
+            << ": " << it.value() << " -> " << result << " ("
+            << (change >= 0 ? "+" : "") << QString::number(change, 'f', 1)
+            << "%)\n";
+    }
+    out << regressions << " regressions over " << tolerance << "%\n";
+    return regressions > 0 ? 1 : 0;
+}
+
+} // unnamed namespace
+
+class AnnotationBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void paintModification_data();
+    void paintModification();
+    void paintTemporalModification_data();
+    void paintTemporalModification();
+    void overrideModifications_data();
+    void overrideModifications();
+    void croppedScreenshot_data();
+    void croppedScreenshot();
+
+private:
+    void addRows();
+};
+
+// addRows adds a row per drawing tool and layout, the worker tools don't
+// paint in the screenshot
+void AnnotationBenchmark::addRows() {
+    QTest::addColumn<int>("tool");
+    QTest::addColumn<int>("layout");
+    const QVector<Layout> allLayouts = layouts();
+    for (int i = 0; i < allLayouts.size(); ++i) {
+        for (const CaptureButton::ButtonType type:
+             CaptureButton::getIterableButtonTypes())
+        {
+            const CaptureTool *tool = ToolFactory::sharedTool(type);
+            if (tool->toolType() == CaptureTool::TYPE_WORKER) {
+                continue;
+            }
+            QString tag = QStringLiteral("%1@%2")
+                    .arg(tool->name(), allLayouts.at(i).name);
+            QTest::newRow(qPrintable(tag)) << static_cast<int>(type) << i;
+        }
+    }
+}
+
+void AnnotationBenchmark::paintModification_data() {
+    addRows();
+}
+
+// paintModification undoes the stroke after painting it, so every iteration
+// paints in the tiles of the canvas without growing the undo history
+void AnnotationBenchmark::paintModification() {
+    QFETCH(int, tool);
+    QFETCH(int, layout);
+    TiledImage canvasImage = createCanvas(layouts().at(layout));
+    Screenshot screenshot(canvasImage);
+    QRect canvas(QPoint(0, 0), canvasImage.size());
+    CaptureModification modification = createModification(
+                static_cast<CaptureButton::ButtonType>(tool), stroke(canvas));
+    const QVector<CaptureModification> remaining;
+    QBENCHMARK {
+        screenshot.paintModification(modification);
+        screenshot.undoModification(remaining);
+    }
+}
+
+void AnnotationBenchmark::paintTemporalModification_data() {
+    addRows();
+}
+
+// paintTemporalModification renders a stroke as it is drawn, a point at a
+// time
+void AnnotationBenchmark::paintTemporalModification() {
+    QFETCH(int, tool);
+    QFETCH(int, layout);
+    TiledImage canvasImage = createCanvas(layouts().at(layout));
+    Screenshot screenshot(canvasImage);
+    QRect canvas(QPoint(0, 0), canvasImage.size());
+    QVector<QPoint> points = stroke(canvas);
+    const auto type = static_cast<CaptureButton::ButtonType>(tool);
+    QBENCHMARK {
+        CaptureModification modification(type, points.first(),
+                                         QColor(Qt::red), THICKNESS);
+        for (int i = 1; i < points.size(); ++i) {
+            modification.addPoint(points.at(i));
+            screenshot.paintTemporalModification(modification);
+        }
+        screenshot.clearTemporalModification();
+    }
+}
+
+void AnnotationBenchmark::overrideModifications_data() {
+    addRows();
+}
+
+void AnnotationBenchmark::overrideModifications() {
+    QFETCH(int, tool);
+    QFETCH(int, layout);
+    TiledImage canvas = createCanvas(layouts().at(layout));
+    Screenshot screenshot(canvas);
+    QVector<CaptureModification> modifications = modificationStream(
+                static_cast<CaptureButton::ButtonType>(tool), canvas.size());
+    QBENCHMARK {
+        screenshot.overrideModifications(modifications);
+    }
+}
+
+void AnnotationBenchmark::croppedScreenshot_data() {
+    addRows();
+}
+
+// croppedScreenshot crops the center of the canvas after painting the
+// modifications
+void AnnotationBenchmark::croppedScreenshot() {
+    QFETCH(int, tool);
+    QFETCH(int, layout);
+    TiledImage canvas = createCanvas(layouts().at(layout));
+    Screenshot screenshot(canvas);
+    QSize size = canvas.size();
+    screenshot.overrideModifications(modificationStream(
+            static_cast<CaptureButton::ButtonType>(tool), size));
+    QRect selection(size.width() / 4, size.height() / 4,
+                    size.width() / 2, size.height() / 2);
+    QBENCHMARK {
+        QPixmap cropped = screenshot.croppedScreenshot(selection);
+        Q_UNUSED(cropped);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc >= 4 && qstrcmp(argv[1], "--compare") == 0) {
+        QCoreApplication app(argc, argv);
+        qreal tolerance = argc >= 5 ? QString(argv[4]).toDouble()
+                                    : DEFAULT_TOLERANCE;
+        return compareResults(argv[2], argv[3], tolerance);
+    }
+    // the benchmarks only paint in images, they don't need a display
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+    // the configuration of the user isn't read
+    app.setApplicationName("flameshot-benchmarks");
+    app.setOrganizationName("Dharkael");
+    AnnotationBenchmark benchmark;
+    return QTest::qExec(&benchmark, argc, argv);
+}
+
+#include "tst_annotation.moc"
@@ -0,0 +1,5 @@
+# Benchmarks of the rendering, they run on the offscreen platform
+
+TEMPLATE = subdirs
+
+SUBDIRS += annotation
@@ -0,0 +1,7 @@
+# Tests of Flameshot, they are built apart from the application with
+# `qmake && make` in this directory
+
+TEMPLATE = subdirs
+
+SUBDIRS += auto \
+    benchmarks